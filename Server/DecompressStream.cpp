@@ -0,0 +1,216 @@
+#include "DecompressStream.h"
+#include <cstdio>
+#include <iostream>
+
+#ifdef TH_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef TH_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+namespace {
+const size_t INPUT_CHUNK = 1 << 20;
+
+bool endsWith(const string &s, const string &suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+struct FileCloser {
+  void operator()(FILE *f) const { fclose(f); }
+};
+using FilePtr = unique_ptr<FILE, FileCloser>;
+
+#ifdef TH_HAVE_ZLIB
+class GzipDecoder : public BlockDecoder {
+  FilePtr file;
+  z_stream zs{};
+  vector<unsigned char> in;
+  bool done = false, bad = false;
+
+public:
+  explicit GzipDecoder(FILE *f) : file(f), in(INPUT_CHUNK) {
+    // 16 + MAX_WBITS: expect a gzip header rather than raw zlib.
+    if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+      bad = done = true;
+  }
+  ~GzipDecoder() override { inflateEnd(&zs); }
+
+  size_t read(char *dst, size_t cap) override {
+    zs.next_out = reinterpret_cast<Bytef *>(dst);
+    zs.avail_out = (uInt)cap;
+    while (!done && zs.avail_out > 0) {
+      if (zs.avail_in == 0) {
+        zs.avail_in = (uInt)fread(in.data(), 1, in.size(), file.get());
+        zs.next_in = in.data();
+        if (zs.avail_in == 0) {
+          done = true; // EOF without Z_STREAM_END: truncated member
+          bad = true;
+          break;
+        }
+      }
+      int rc = inflate(&zs, Z_NO_FLUSH);
+      if (rc == Z_STREAM_END) {
+        // Concatenated members (cat a.gz b.gz) are valid gzip; stop only
+        // when no input follows the member.
+        if (zs.avail_in == 0) {
+          zs.avail_in = (uInt)fread(in.data(), 1, in.size(), file.get());
+          zs.next_in = in.data();
+        }
+        if (zs.avail_in == 0)
+          done = true;
+        else
+          inflateReset(&zs);
+      } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+        done = bad = true;
+      }
+    }
+    return cap - zs.avail_out;
+  }
+  bool failed() const override { return bad; }
+};
+#endif
+
+#ifdef TH_HAVE_ZSTD
+class ZstdDecoder : public BlockDecoder {
+  FilePtr file;
+  ZSTD_DStream *ds;
+  vector<char> in;
+  ZSTD_inBuffer input{nullptr, 0, 0};
+  bool done = false, bad = false;
+  size_t lastHint = 1; // 0 once a frame has been fully decoded
+
+public:
+  explicit ZstdDecoder(FILE *f)
+      : file(f), ds(ZSTD_createDStream()), in(ZSTD_DStreamInSize()) {
+    if (ds == nullptr || ZSTD_isError(ZSTD_initDStream(ds)))
+      bad = done = true;
+  }
+  ~ZstdDecoder() override { ZSTD_freeDStream(ds); }
+
+  size_t read(char *dst, size_t cap) override {
+    ZSTD_outBuffer output{dst, cap, 0};
+    while (!done && output.pos < output.size) {
+      if (input.pos == input.size) {
+        input.size = fread(in.data(), 1, in.size(), file.get());
+        input.src = in.data();
+        input.pos = 0;
+        if (input.size == 0) {
+          done = true;
+          bad = lastHint != 0; // EOF in the middle of a frame
+          break;
+        }
+      }
+      lastHint = ZSTD_decompressStream(ds, &output, &input);
+      if (ZSTD_isError(lastHint))
+        done = bad = true;
+    }
+    return output.pos;
+  }
+  bool failed() const override { return bad; }
+};
+#endif
+} // namespace
+
+Compression compressionFor(const string &path) {
+  if (endsWith(path, ".gz"))
+    return Compression::Gzip;
+  if (endsWith(path, ".zst"))
+    return Compression::Zstd;
+  return Compression::None;
+}
+
+const char *compressionName(Compression c) {
+  switch (c) {
+  case Compression::Gzip:
+    return "gzip";
+  case Compression::Zstd:
+    return "zstd";
+  default:
+    return "none";
+  }
+}
+
+DecompressStream::DecompressStream(size_t blockBytes) {
+  for (Buffer &b : buffers)
+    b.data.resize(blockBytes);
+}
+
+DecompressStream::~DecompressStream() {
+  {
+    lock_guard<mutex> lock(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+  if (worker.joinable())
+    worker.join();
+}
+
+bool DecompressStream::open(const string &path) {
+  Compression c = compressionFor(path);
+  FILE *f = fopen(path.c_str(), "rb");
+  if (f == nullptr)
+    return false;
+  switch (c) {
+#ifdef TH_HAVE_ZLIB
+  case Compression::Gzip:
+    decoder = make_unique<GzipDecoder>(f);
+    break;
+#endif
+#ifdef TH_HAVE_ZSTD
+  case Compression::Zstd:
+    decoder = make_unique<ZstdDecoder>(f);
+    break;
+#endif
+  default:
+    fclose(f);
+    cerr << "Error: no " << compressionName(c) << " support for " << path
+         << endl;
+    return false;
+  }
+  worker = thread(&DecompressStream::run, this);
+  return true;
+}
+
+void DecompressStream::run() {
+  for (size_t i = 0;; i ^= 1) {
+    Buffer &b = buffers[i];
+    {
+      unique_lock<mutex> lock(mtx);
+      cv.wait(lock, [&] { return !b.full || stopping; });
+      if (stopping)
+        return;
+    }
+    // Decompress outside the lock; the consumer only touches full buffers.
+    size_t n = decoder->read(b.data.data(), b.data.size());
+    {
+      lock_guard<mutex> lock(mtx);
+      b.size = n;
+      b.full = n > 0;
+      if (n < b.data.size()) {
+        finished = true;
+        error = decoder->failed();
+      }
+    }
+    cv.notify_all();
+    if (n < b.data.size())
+      return;
+  }
+}
+
+bool DecompressStream::readBlock(string &out) {
+  Buffer &b = buffers[readIdx];
+  unique_lock<mutex> lock(mtx);
+  cv.wait(lock, [&] { return b.full || finished; });
+  if (!b.full)
+    return false;
+  out.append(b.data.data(), b.size);
+  b.full = false;
+  readIdx ^= 1;
+  lock.unlock();
+  cv.notify_all();
+  return true;
+}
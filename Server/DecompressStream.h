@@ -0,0 +1,67 @@
+#ifndef DECOMPRESS_STREAM_H
+#define DECOMPRESS_STREAM_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compression is chosen by extension: .gz (zlib, TH_HAVE_ZLIB) and .zst
+// (libzstd, TH_HAVE_ZSTD). Anything else is read as plain text.
+enum class Compression { None, Gzip, Zstd };
+
+Compression compressionFor(const std::string &path);
+const char *compressionName(Compression c);
+
+// Incremental decoder of one compressed file.
+class BlockDecoder {
+public:
+  virtual ~BlockDecoder() = default;
+  // Fills up to `cap` bytes; returns 0 at end of stream or on error.
+  virtual size_t read(char *dst, size_t cap) = 0;
+  virtual bool failed() const = 0;
+};
+
+// --- Decompression on its own thread, handed over through a double buffer ---
+// The worker fills one buffer while the consumer parses the other, so
+// decompression overlaps parsing and memory stays at two blocks no matter
+// how large the file is.
+class DecompressStream {
+private:
+  struct Buffer {
+    std::vector<char> data;
+    size_t size = 0;
+    bool full = false;
+  };
+
+  std::unique_ptr<BlockDecoder> decoder;
+  Buffer buffers[2];
+  size_t readIdx = 0;
+  bool finished = false; // worker reached end of stream (or failed)
+  bool stopping = false;
+  bool error = false;
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::thread worker;
+
+  void run();
+
+public:
+  explicit DecompressStream(size_t blockBytes = 4 << 20);
+  ~DecompressStream();
+  DecompressStream(const DecompressStream &) = delete;
+  DecompressStream &operator=(const DecompressStream &) = delete;
+
+  // Opens a .gz / .zst file and starts the worker. False if the file cannot
+  // be opened or this build lacks the codec.
+  bool open(const std::string &path);
+  // Appends the next decompressed block to `out`; false at end of stream.
+  bool readBlock(std::string &out);
+  // True if the stream ended because of a corrupt or truncated input.
+  bool failed() const { return error; }
+};
+
+#endif // DECOMPRESS_STREAM_H
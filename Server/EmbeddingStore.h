@@ -0,0 +1,109 @@
+#ifndef EMBEDDING_STORE_H
+#define EMBEDDING_STORE_H
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// ==========================================
+// Binary zone embedding store (.bin)
+// ==========================================
+// File layout (every section starts on an 8-byte boundary):
+//   EmbeddingHeader
+//   EmbeddingZone zones[numZones]     -> sorted by name (binary search)
+//   char   names[namesBytes]          -> zone names, not NUL-terminated
+//   float  latest[numZones * dim]     -> most recent embedding per zone
+//   int64  historyFecha[numHistory]   -> optional, zone-major, by date
+//   float  history[numHistory * dim]
+// Written by the trainer, mapped by the server (no CSV parsing).
+
+const uint32_t EMBEDDING_FORMAT_VERSION = 1;
+
+struct EmbeddingHeader {
+  char magic[4]; // "THEM"
+  uint32_t version;
+  uint32_t numZones;
+  uint32_t dim;
+  uint64_t namesBytes;
+  uint64_t numHistory; // 0 when only the latest embeddings were exported
+};
+
+struct EmbeddingZone {
+  uint32_t nameOfs; // into names[]
+  uint32_t nameLen;
+  int64_t latestFecha;   // YYYYMMDD of latest[]; -1 if the zone has none
+  uint64_t historyBegin; // rows [historyBegin, historyBegin + historyCount)
+  uint64_t historyCount;
+};
+
+// --- Read side: the mapped file, accessed in place ---
+class EmbeddingStore {
+private:
+  MappedFile file;
+  const EmbeddingHeader *header = nullptr;
+  const EmbeddingZone *zones = nullptr;
+  const char *names = nullptr;
+  const float *latestRows = nullptr;
+  const int64_t *historyFechas = nullptr;
+  const float *historyRows = nullptr;
+
+  bool bind(const char *base, size_t size);
+
+public:
+  // Maps the file; fails (and leaves the store empty) if the magic,
+  // version, sizes or embedding dimension do not match.
+  bool load(const std::string &path, uint32_t expectedDim);
+
+  bool empty() const { return header == nullptr; }
+  uint32_t numZones() const { return header ? header->numZones : 0; }
+  uint32_t dim() const { return header ? header->dim : 0; }
+  uint64_t numHistory() const { return header ? header->numHistory : 0; }
+
+  std::string zoneName(uint32_t z) const {
+    return std::string(names + zones[z].nameOfs, zones[z].nameLen);
+  }
+  // Index of the zone, or -1.
+  int64_t find(const std::string &name) const;
+  int64_t latestFecha(uint32_t z) const { return zones[z].latestFecha; }
+  const float *latest(uint32_t z) const {
+    return latestRows + (size_t)z * header->dim;
+  }
+  uint64_t historyCount(uint32_t z) const { return zones[z].historyCount; }
+  int64_t historyFecha(uint32_t z, uint64_t k) const {
+    return historyFechas[zones[z].historyBegin + k];
+  }
+  const float *history(uint32_t z, uint64_t k) const {
+    return historyRows + (zones[z].historyBegin + k) * header->dim;
+  }
+};
+
+// --- Write side: streams rows straight to their final offsets ---
+// The file is laid out up front from the per-zone history counts, so
+// history rows go to disk as they arrive and only the latest embedding of
+// each zone is kept in memory. Rows of one zone must arrive in date order
+// when history is exported.
+class EmbeddingStoreWriter {
+private:
+  std::string path;
+  std::fstream out;
+  uint32_t dimension = 0;
+  std::vector<EmbeddingZone> table; // sorted-name order
+  std::vector<uint32_t> slotOf;     // caller's zone index -> table slot
+  std::vector<uint64_t> cursor;     // next history row per slot
+  std::vector<float> latestRows;
+  size_t latestOfs = 0, fechaOfs = 0, historyOfs = 0;
+  bool writeHistory = false;
+
+public:
+  // historyCounts[z] = rows that will be added for zone z; pass an empty
+  // vector to export only the latest embedding per zone.
+  bool begin(const std::string &path, const std::vector<std::string> &zoneNames,
+             uint32_t dim, const std::vector<uint64_t> &historyCounts);
+  void add(uint32_t zone, int64_t fecha, const float *embedding);
+  // Writes the zone table and latest rows, then renames the file into place.
+  bool finish();
+};
+
+#endif // EMBEDDING_STORE_H
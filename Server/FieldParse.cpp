@@ -0,0 +1,135 @@
+#include "FieldParse.h"
+#include <charconv>
+#include <system_error>
+
+using namespace std;
+
+namespace {
+bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+string_view trim(string_view s) {
+  while (!s.empty() && isBlank(s.front()))
+    s.remove_prefix(1);
+  while (!s.empty() && isBlank(s.back()))
+    s.remove_suffix(1);
+  return s;
+}
+
+// Trims and drops a leading '+', which from_chars does not accept.
+string_view prepare(string_view s) {
+  s = trim(s);
+  if (s.size() > 1 && s.front() == '+' && s[1] != '-')
+    s.remove_prefix(1);
+  return s;
+}
+
+ParseError fromErrc(errc ec) {
+  if (ec == errc::result_out_of_range)
+    return ParseError::OutOfRange;
+  return ec == errc() ? ParseError::None : ParseError::Invalid;
+}
+
+// Parses a run of 1..maxDigits digits as an int; advances p.
+bool digits(const char *&p, const char *end, int maxDigits, int &out) {
+  const char *start = p;
+  out = 0;
+  while (p < end && *p >= '0' && *p <= '9' && p - start < maxDigits)
+    out = out * 10 + (*p++ - '0');
+  return p > start;
+}
+} // namespace
+
+const char *parseErrorName(ParseError e) {
+  switch (e) {
+  case ParseError::None:
+    return "ok";
+  case ParseError::Empty:
+    return "empty";
+  case ParseError::Invalid:
+    return "invalid";
+  case ParseError::OutOfRange:
+    return "out of range";
+  }
+  return "?";
+}
+
+ParseError parseFloat(string_view s, float &out) {
+  s = prepare(s);
+  if (s.empty())
+    return ParseError::Empty;
+  float v;
+  auto [ptr, ec] = from_chars(s.data(), s.data() + s.size(), v);
+  if (ec != errc())
+    return fromErrc(ec);
+  if (ptr != s.data() + s.size())
+    return ParseError::Invalid;
+  out = v;
+  return ParseError::None;
+}
+
+ParseError parseInt(string_view s, int64_t &out) {
+  s = prepare(s);
+  if (s.empty())
+    return ParseError::Empty;
+  const char *end = s.data() + s.size();
+  int64_t v;
+  auto [ptr, ec] = from_chars(s.data(), end, v);
+  if (ec != errc())
+    return fromErrc(ec);
+  if (ptr != end) {
+    // "20251001.0": accept a digits-only fraction and truncate it.
+    if (*ptr != '.')
+      return ParseError::Invalid;
+    for (++ptr; ptr < end; ++ptr)
+      if (*ptr < '0' || *ptr > '9')
+        return ParseError::Invalid;
+  }
+  out = v;
+  return ParseError::None;
+}
+
+ParseError parseDateDmy(string_view s, int64_t &yyyymmdd) {
+  s = trim(s);
+  if (s.empty())
+    return ParseError::Empty;
+  const char *p = s.data(), *end = p + s.size();
+  int d, m, y;
+  if (!digits(p, end, 2, d) || p == end || *p++ != '/' ||
+      !digits(p, end, 2, m) || p == end || *p++ != '/' ||
+      !digits(p, end, 4, y) || p != end)
+    return ParseError::Invalid;
+  if (d < 1 || d > 31 || m < 1 || m > 12)
+    return ParseError::OutOfRange;
+  yyyymmdd = (int64_t)y * 10000 + m * 100 + d;
+  return ParseError::None;
+}
+
+size_t parseFloatColumn(const string_view *cells, size_t n, float *out,
+                        float fallback) {
+  size_t failed = 0;
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = fallback;
+    failed += parseFloat(cells[i], out[i]) != ParseError::None;
+  }
+  return failed;
+}
+
+size_t parseIntColumn(const string_view *cells, size_t n, int64_t *out,
+                      int64_t fallback) {
+  size_t failed = 0;
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = fallback;
+    failed += parseInt(cells[i], out[i]) != ParseError::None;
+  }
+  return failed;
+}
+
+size_t parseDateColumn(const string_view *cells, size_t n, int64_t *out,
+                       int64_t fallback) {
+  size_t failed = 0;
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = fallback;
+    failed += parseDateDmy(cells[i], out[i]) != ParseError::None;
+  }
+  return failed;
+}
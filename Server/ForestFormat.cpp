@@ -0,0 +1,214 @@
+#include "ForestFormat.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const char FOREST_MAGIC[4] = {'T', 'H', 'R', 'F'};
+
+size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+
+struct ForestLayout {
+  size_t rootsOfs, nodesOfs, classesOfs, total;
+};
+
+ForestLayout layoutFor(uint32_t numTrees, uint32_t numNodes,
+                       uint32_t numClasses) {
+  ForestLayout l;
+  l.rootsOfs = align8(sizeof(ForestHeader));
+  l.nodesOfs = align8(l.rootsOfs + numTrees * sizeof(int32_t));
+  l.classesOfs = align8(l.nodesOfs + (size_t)numNodes * sizeof(ForestNode));
+  l.total = align8(l.classesOfs + numClasses * sizeof(float));
+  return l;
+}
+} // namespace
+
+uint64_t forestSchemaHash(const vector<string> &featureNames) {
+  uint64_t h = 1469598103934665603ULL;
+  auto mix = [&h](unsigned char c) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  };
+  for (size_t i = 0; i < featureNames.size(); ++i) {
+    if (i > 0)
+      mix(',');
+    for (unsigned char c : featureNames[i])
+      mix(c);
+  }
+  return h;
+}
+
+bool readForestHeader(const string &path, ForestHeader &header) {
+  ifstream in(path, ios::binary);
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+    return false;
+  return memcmp(header.magic, FOREST_MAGIC, 4) == 0 &&
+         header.version == FOREST_FORMAT_VERSION;
+}
+
+// ==========================================
+// FlatForest Implementation
+// ==========================================
+bool FlatForest::bind(const char *base, size_t size) {
+  header = nullptr;
+  if (base == nullptr || size < sizeof(ForestHeader))
+    return false;
+
+  const ForestHeader *h = reinterpret_cast<const ForestHeader *>(base);
+  if (memcmp(h->magic, FOREST_MAGIC, 4) != 0 ||
+      h->version != FOREST_FORMAT_VERSION || h->numTrees == 0)
+    return false;
+
+  ForestLayout l = layoutFor(h->numTrees, h->numNodes, h->numClasses);
+  if (size < l.total)
+    return false;
+
+  roots = reinterpret_cast<const int32_t *>(base + l.rootsOfs);
+  nodes = reinterpret_cast<const ForestNode *>(base + l.nodesOfs);
+  classValues = reinterpret_cast<const float *>(base + l.classesOfs);
+
+  // Reject files whose indices would walk out of the arrays. Children must
+  // come after their parent, so every descent ends at a leaf.
+  for (uint32_t t = 0; t < h->numTrees; ++t)
+    if (roots[t] < 0 || (uint32_t)roots[t] >= h->numNodes)
+      return false;
+  for (uint32_t i = 0; i < h->numNodes; ++i) {
+    const ForestNode &n = nodes[i];
+    if (n.feature < 0) {
+      if (n.classIdx < 0 || (uint32_t)n.classIdx >= h->numClasses)
+        return false;
+    } else if ((uint32_t)n.feature >= h->numFeatures ||
+               n.left <= (int32_t)i || n.right <= (int32_t)i ||
+               (uint32_t)n.left >= h->numNodes ||
+               (uint32_t)n.right >= h->numNodes) {
+      return false;
+    }
+  }
+
+  header = h;
+  return true;
+}
+
+bool FlatForest::load(const string &path, uint64_t expectedSchemaHash) {
+  header = nullptr;
+  owned.clear();
+  if (!file.open(path))
+    return false;
+  if (!bind(file.data(), file.size())) {
+    cerr << "Invalid forest file: " << path << endl;
+    file.close();
+    return false;
+  }
+  if (header->schemaHash != expectedSchemaHash) {
+    cerr << "Forest schema mismatch: " << path << endl;
+    header = nullptr;
+    file.close();
+    return false;
+  }
+  return true;
+}
+
+bool FlatForest::adopt(vector<char> image) {
+  file.close();
+  owned = std::move(image);
+  return bind(owned.data(), owned.size());
+}
+
+bool FlatForest::save(const string &path) const {
+  if (empty())
+    return false;
+  const char *base = reinterpret_cast<const char *>(header);
+  ForestLayout l =
+      layoutFor(header->numTrees, header->numNodes, header->numClasses);
+  ofstream out(path, ios::binary | ios::trunc);
+  if (!out.is_open()) {
+    cerr << "Error saving forest: " << path << endl;
+    return false;
+  }
+  out.write(base, l.total);
+  return out.good();
+}
+
+int FlatForest::leafClass(const float *features, uint32_t tree) const {
+  const ForestNode *n = &nodes[roots[tree]];
+  while (n->feature >= 0)
+    n = &nodes[features[n->feature] <= n->threshold ? n->left : n->right];
+  return n->classIdx;
+}
+
+float FlatForest::predict(const float *features) const {
+  if (empty())
+    return 0.0f;
+  // Few classes in practice (binary risk), so a small stack buffer suffices.
+  uint32_t stackVotes[16] = {0};
+  vector<uint32_t> heapVotes;
+  uint32_t *votes = stackVotes;
+  if (header->numClasses > 16) {
+    heapVotes.assign(header->numClasses, 0);
+    votes = heapVotes.data();
+  }
+
+  for (uint32_t t = 0; t < header->numTrees; ++t)
+    votes[leafClass(features, t)]++;
+
+  uint32_t best = 0;
+  for (uint32_t c = 1; c < header->numClasses; ++c)
+    if (votes[c] > votes[best])
+      best = c;
+  return classValues[best];
+}
+
+float FlatForest::voteShare(const float *features, float classValue) const {
+  if (empty())
+    return 0.0f;
+  uint32_t hits = 0;
+  for (uint32_t t = 0; t < header->numTrees; ++t)
+    if (classValues[leafClass(features, t)] == classValue)
+      hits++;
+  return (float)hits / (float)header->numTrees;
+}
+
+// ==========================================
+// ForestBuilder Implementation
+// ==========================================
+int32_t ForestBuilder::classIndex(float value) {
+  for (size_t i = 0; i < classValues.size(); ++i)
+    if (classValues[i] == value)
+      return (int32_t)i;
+  classValues.push_back(value);
+  return (int32_t)classValues.size() - 1;
+}
+
+void ForestBuilder::beginTree() { roots.push_back((int32_t)nodes.size()); }
+
+int32_t ForestBuilder::addNode(const ForestNode &node) {
+  nodes.push_back(node);
+  return (int32_t)nodes.size() - 1;
+}
+
+vector<char> ForestBuilder::serialize(uint32_t numFeatures,
+                                      uint64_t schemaHash) const {
+  ForestLayout l = layoutFor((uint32_t)roots.size(), (uint32_t)nodes.size(),
+                             (uint32_t)classValues.size());
+  vector<char> image(l.total, 0);
+
+  ForestHeader h;
+  memcpy(h.magic, FOREST_MAGIC, 4);
+  h.version = FOREST_FORMAT_VERSION;
+  h.numTrees = (uint32_t)roots.size();
+  h.numNodes = (uint32_t)nodes.size();
+  h.numFeatures = numFeatures;
+  h.numClasses = (uint32_t)classValues.size();
+  h.schemaHash = schemaHash;
+
+  memcpy(image.data(), &h, sizeof(h));
+  memcpy(image.data() + l.rootsOfs, roots.data(),
+         roots.size() * sizeof(int32_t));
+  memcpy(image.data() + l.nodesOfs, nodes.data(),
+         nodes.size() * sizeof(ForestNode));
+  memcpy(image.data() + l.classesOfs, classValues.data(),
+         classValues.size() * sizeof(float));
+  return image;
+}
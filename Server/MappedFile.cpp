@@ -0,0 +1,73 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : base(other.base), length(other.length), opened(other.opened) {
+  other.base = nullptr;
+  other.length = 0;
+  other.opened = false;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    base = other.base;
+    length = other.length;
+    opened = other.opened;
+    other.base = nullptr;
+    other.length = 0;
+    other.opened = false;
+  }
+  return *this;
+}
+
+bool MappedFile::open(const string &path, bool copyOnWrite) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  length = (size_t)st.st_size;
+  if (length > 0) {
+    int prot = copyOnWrite ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void *ptr = mmap(nullptr, length, prot, MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED) {
+      cerr << "Error mapping file: " << path << endl;
+      ::close(fd);
+      length = 0;
+      return false;
+    }
+    base = static_cast<char *>(ptr);
+  }
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  opened = true;
+  return true;
+}
+
+void MappedFile::close() {
+  if (base != nullptr)
+    munmap(base, length);
+  base = nullptr;
+  length = 0;
+  opened = false;
+}
+
+void MappedFile::adviseSequential() {
+  if (base != nullptr)
+    madvise(base, length, MADV_SEQUENTIAL);
+}
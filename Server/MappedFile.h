@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// --- Read-only (or copy-on-write) memory mapping of a whole file ---
+// The mapping lives as long as the object; moving transfers ownership.
+class MappedFile {
+private:
+  char *base = nullptr;
+  size_t length = 0;
+  bool opened = false;
+
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  // copyOnWrite maps the pages MAP_PRIVATE and writable, so callers can
+  // modify them in place without touching the file on disk.
+  bool open(const std::string &path, bool copyOnWrite = false);
+  void close();
+  void adviseSequential();
+
+  const char *data() const { return base; }
+  char *mutableData() { return base; }
+  size_t size() const { return length; }
+  bool isOpen() const { return opened; }
+};
+
+#endif // MAPPED_FILE_H
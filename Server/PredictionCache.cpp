@@ -0,0 +1,88 @@
+#include "PredictionCache.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+PredictionCache::PredictionCache(chrono::milliseconds ttl) : ttl(ttl) {}
+
+void PredictionCache::sweepExpiredLocked(Clock::time_point now) {
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->second.ready && it->second.expires <= now) {
+      it = entries.erase(it);
+      evictions++;
+    } else {
+      ++it;
+    }
+  }
+  sweepThreshold = max<size_t>(1024, entries.size() * 2);
+}
+
+float PredictionCache::getOrCompute(const string &zone, uint64_t version,
+                                    const function<float()> &compute) {
+  string key = zone;
+  key += '\x1f';
+  key += to_string(version);
+
+  promise<float> producer;
+  unique_lock<mutex> lock(mtx);
+  Clock::time_point now = Clock::now();
+  auto it = entries.find(key);
+  if (it != entries.end()) {
+    if (!it->second.ready) {
+      // Someone is already computing this zone: wait for their result.
+      coalesced++;
+      shared_future<float> pending = it->second.result;
+      lock.unlock();
+      return pending.get();
+    }
+    if (it->second.expires > now) {
+      hits++;
+      return it->second.result.get();
+    }
+    entries.erase(it);
+    evictions++;
+  }
+
+  if (entries.size() >= sweepThreshold)
+    sweepExpiredLocked(now);
+
+  Entry entry;
+  entry.result = producer.get_future().share();
+  entries.emplace(key, std::move(entry));
+  misses++;
+  lock.unlock();
+
+  float value;
+  try {
+    value = compute();
+  } catch (...) {
+    producer.set_exception(current_exception());
+    lock.lock();
+    entries.erase(key);
+    throw;
+  }
+
+  producer.set_value(value);
+  lock.lock();
+  it = entries.find(key);
+  if (it != entries.end()) {
+    if (ttl.count() <= 0) {
+      entries.erase(it); // single-flight only, no result caching
+    } else {
+      it->second.ready = true;
+      it->second.expires = Clock::now() + ttl;
+    }
+  }
+  return value;
+}
+
+CacheStats PredictionCache::stats() const {
+  CacheStats s;
+  s.hits = hits.load();
+  s.misses = misses.load();
+  s.coalesced = coalesced.load();
+  s.evictions = evictions.load();
+  lock_guard<mutex> lock(mtx);
+  s.entries = entries.size();
+  return s;
+}
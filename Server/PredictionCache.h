@@ -0,0 +1,54 @@
+#ifndef PREDICTION_CACHE_H
+#define PREDICTION_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct CacheStats {
+  uint64_t hits = 0;      // served from a finished, non-expired entry
+  uint64_t misses = 0;    // ran the computation
+  uint64_t coalesced = 0; // waited on another request's computation
+  uint64_t evictions = 0; // expired entries removed
+  size_t entries = 0;
+};
+
+// --- Single-flight + short-lived result cache for zone predictions ---
+// Keyed by (zone, snapshot version): concurrent identical requests share
+// one computation, and the result is reused for `ttl` afterwards. A new
+// snapshot version never matches old entries, so stale results are not
+// served after the data changes.
+class PredictionCache {
+private:
+  struct Entry {
+    std::shared_future<float> result;
+    std::chrono::steady_clock::time_point expires;
+    bool ready = false;
+  };
+
+  mutable std::mutex mtx;
+  std::unordered_map<std::string, Entry> entries;
+  std::chrono::milliseconds ttl;
+  size_t sweepThreshold = 1024;
+  std::atomic<uint64_t> hits{0}, misses{0}, coalesced{0}, evictions{0};
+
+  void sweepExpiredLocked(std::chrono::steady_clock::time_point now);
+
+public:
+  explicit PredictionCache(std::chrono::milliseconds ttl);
+
+  // Exceptions thrown by compute propagate to every waiting caller and the
+  // entry is dropped, so the next request retries.
+  float getOrCompute(const std::string &zone, uint64_t version,
+                     const std::function<float()> &compute);
+
+  CacheStats stats() const;
+  std::chrono::milliseconds timeToLive() const { return ttl; }
+};
+
+#endif // PREDICTION_CACHE_H
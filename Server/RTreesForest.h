@@ -0,0 +1,13 @@
+#ifndef RTREES_FOREST_H
+#define RTREES_FOREST_H
+
+#include "ForestFormat.h"
+#include <opencv2/ml.hpp>
+
+// Flattens a trained cv::ml::RTrees (classification, ordered splits only)
+// into the binary forest format. Returns false if the model uses
+// categorical splits, which the flat format does not represent.
+bool forestFromRTrees(const cv::Ptr<cv::ml::RTrees> &model,
+                      uint32_t numFeatures, ForestBuilder &builder);
+
+#endif // RTREES_FOREST_H
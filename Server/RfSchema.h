@@ -0,0 +1,59 @@
+#ifndef RF_SCHEMA_H
+#define RF_SCHEMA_H
+
+#include "ForestFormat.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// ==========================================
+// Random Forest feature schema
+// ==========================================
+// An RF row is the zone's LSTM embedding (emb_1..emb_N) followed by its
+// INEC columns. The trainer and both servers name the columns here, so the
+// schema hash in the .bin means the same on every side. A model may be
+// trained on the embeddings alone (mainV2 does); the servers still build
+// full rows and such a model reads only the leading columns.
+
+inline std::vector<std::string>
+rfFeatureSchema(int embDim, const std::vector<std::string> &inecNames = {}) {
+  std::vector<std::string> names;
+  for (int i = 1; i <= embDim; ++i)
+    names.push_back("emb_" + std::to_string(i));
+  names.insert(names.end(), inecNames.begin(), inecNames.end());
+  return names;
+}
+
+// Columns of a model trained on numFeatures of them: embeddings only or
+// embeddings + INEC. Empty when numFeatures matches neither layout.
+inline std::vector<std::string>
+rfTrainedSchema(size_t numFeatures, int embDim,
+                const std::vector<std::string> &inecNames) {
+  std::vector<std::string> names = rfFeatureSchema(embDim, inecNames);
+  if (numFeatures == (size_t)embDim)
+    names.resize(numFeatures);
+  else if (numFeatures != names.size())
+    names.clear();
+  return names;
+}
+
+// Maps a .bin trained on either layout; its numFeatures picks the schema
+// whose hash it must carry.
+inline bool loadRfForest(FlatForest &forest, const std::string &path,
+                         int embDim,
+                         const std::vector<std::string> &inecNames) {
+  ForestHeader header;
+  if (!readForestHeader(path, header))
+    return false;
+  std::vector<std::string> schema =
+      rfTrainedSchema(header.numFeatures, embDim, inecNames);
+  if (schema.empty()) {
+    std::cerr << "Forest " << path << " has " << header.numFeatures
+              << " features; expected " << embDim << " or "
+              << embDim + inecNames.size() << std::endl;
+    return false;
+  }
+  return forest.load(path, forestSchemaHash(schema));
+}
+
+#endif // RF_SCHEMA_H
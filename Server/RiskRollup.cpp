@@ -0,0 +1,140 @@
+#include "RiskRollup.h"
+#include "json.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+
+using json = nlohmann::json;
+using namespace std;
+
+vector<CantonInfo> loadCantonMembership(const string &path) {
+  vector<CantonInfo> cantones;
+  ifstream file(path);
+  if (!file.is_open()) {
+    cerr << "[WARN] No se pudo abrir mapeo de zonas: " << path << endl;
+    return cantones;
+  }
+  json data = json::parse(file, nullptr, false);
+  if (!data.is_array()) {
+    cerr << "[WARN] Mapeo de zonas invalido: " << path << endl;
+    return cantones;
+  }
+  for (const auto &z : data) {
+    if (!z.contains("nombreProvincia") || !z.contains("nombreCanton"))
+      continue;
+    CantonInfo c;
+    c.idProvincia = z.value("idProvincia", -1);
+    c.idCanton = z.value("idCanton", -1);
+    c.provincia = normalizeZoneName(z["nombreProvincia"].get<string>());
+    c.canton = normalizeZoneName(z["nombreCanton"].get<string>());
+    cantones.push_back(std::move(c));
+  }
+  cout << "[INFO] Mapeo provincia/canton: " << cantones.size() << " cantones."
+       << endl;
+  return cantones;
+}
+
+string normalizeZoneName(const string &name) {
+  const auto b = name.find_first_not_of(" \t\r\n");
+  if (b == string::npos)
+    return "";
+  const auto e = name.find_last_not_of(" \t\r\n");
+  string out = name.substr(b, e - b + 1);
+  for (char &ch : out)
+    ch = (char)toupper((unsigned char)ch);
+  return out;
+}
+
+namespace {
+struct Aggregate {
+  size_t total = 0;
+  size_t conDatos = 0;
+  size_t altos = 0;
+  double sumaScore = 0.0;
+  vector<const CantonScore *> cantones;
+};
+
+json cantonJson(const CantonScore &c) {
+  return json{{"canton", c.canton},
+              {"provincia", c.provincia},
+              {"score", c.score},
+              {"nivel", c.alto ? "ALTO" : "BAJO"}};
+}
+
+json aggregateJson(const Aggregate &a, size_t topK) {
+  json out;
+  out["cantones_total"] = a.total;
+  out["cantones_con_datos"] = a.conDatos;
+  out["cantones_alto_riesgo"] = a.altos;
+  out["proporcion_alto_riesgo"] =
+      a.conDatos ? (double)a.altos / a.conDatos : 0.0;
+  out["score_medio"] = a.conDatos ? a.sumaScore / a.conDatos : 0.0;
+  json top = json::array();
+  for (size_t i = 0; i < a.cantones.size() && i < topK; ++i)
+    top.push_back(cantonJson(*a.cantones[i]));
+  out["top"] = top;
+  return out;
+}
+
+bool riskierFirst(const CantonScore &a, const CantonScore &b) {
+  if (a.score != b.score)
+    return a.score > b.score;
+  return a.canton < b.canton; // orden estable entre snapshots
+}
+} // namespace
+
+shared_ptr<const RiskSnapshot>
+RiskSnapshot::build(const vector<CantonInfo> &membership, const Scorer &scorer,
+                    size_t topPerProvince, long fechaDatos) {
+  auto snap = make_shared<RiskSnapshot>();
+
+  unordered_map<string, Aggregate> porProvincia;
+  Aggregate nacional;
+  for (const CantonInfo &c : membership) {
+    porProvincia[c.provincia].total++;
+    nacional.total++;
+    CantonScore s;
+    if (!scorer(c, s))
+      continue;
+    s.canton = c.canton;
+    s.provincia = c.provincia;
+    snap->ranking.push_back(std::move(s));
+  }
+  sort(snap->ranking.begin(), snap->ranking.end(), riskierFirst);
+
+  // El ranking ya está ordenado, así que cada provincia hereda el orden.
+  for (const CantonScore &s : snap->ranking) {
+    for (Aggregate *a : {&porProvincia[s.provincia], &nacional}) {
+      a->conDatos++;
+      a->altos += s.alto ? 1 : 0;
+      a->sumaScore += s.score;
+      a->cantones.push_back(&s);
+    }
+  }
+
+  for (const auto &[nombre, agg] : porProvincia) {
+    json out = aggregateJson(agg, topPerProvince);
+    out["provincia"] = nombre;
+    out["fecha_datos"] = fechaDatos;
+    snap->provinceJson[nombre] = out.dump();
+  }
+  json nac = aggregateJson(nacional, 0);
+  nac.erase("top");
+  nac["provincias"] = porProvincia.size();
+  nac["fecha_datos"] = fechaDatos;
+  snap->nationalJson = nac.dump();
+  return snap;
+}
+
+const string *RiskSnapshot::province(const string &name) const {
+  auto it = provinceJson.find(normalizeZoneName(name));
+  return it == provinceJson.end() ? nullptr : &it->second;
+}
+
+string RiskSnapshot::top(size_t k) const {
+  json lista = json::array();
+  for (size_t i = 0; i < ranking.size() && i < k; ++i)
+    lista.push_back(cantonJson(ranking[i]));
+  return "{\"nacional\":" + nationalJson + ",\"top\":" + lista.dump() + "}";
+}
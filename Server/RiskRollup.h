@@ -0,0 +1,55 @@
+#ifndef RISK_ROLLUP_H
+#define RISK_ROLLUP_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Pertenencia Provincia -> Cantón (zonas_mapeadas.json del frontend)
+struct CantonInfo {
+  int idProvincia;
+  int idCanton;
+  std::string provincia;
+  std::string canton;
+};
+
+struct CantonScore {
+  std::string canton;
+  std::string provincia;
+  float score; // fracción de árboles que votan "alto riesgo" (0..1)
+  bool alto;
+};
+
+std::vector<CantonInfo> loadCantonMembership(const std::string &path);
+
+// Upper-case ASCII + trim, so "guayas " and "GUAYAS" hit the same entry.
+std::string normalizeZoneName(const std::string &name);
+
+// --- Province / national aggregates of one data snapshot ---
+// Built once when the snapshot is loaded; lookups afterwards are a hash
+// probe (province) or a prefix of the precomputed ranking (top-k).
+class RiskSnapshot {
+public:
+  // Returns false when the canton has no data in this snapshot.
+  using Scorer = std::function<bool(const CantonInfo &, CantonScore &)>;
+
+  static std::shared_ptr<const RiskSnapshot>
+  build(const std::vector<CantonInfo> &membership, const Scorer &scorer,
+        size_t topPerProvince, long fechaDatos);
+
+  // Pre-serialized JSON for the province, or nullptr if unknown.
+  const std::string *province(const std::string &name) const;
+  // National aggregates plus the k riskiest cantons, as JSON.
+  std::string top(size_t k) const;
+  size_t numProvinces() const { return provinceJson.size(); }
+  size_t numScored() const { return ranking.size(); }
+
+private:
+  std::unordered_map<std::string, std::string> provinceJson;
+  std::string nationalJson; // objeto "nacional" ya serializado
+  std::vector<CantonScore> ranking; // score descendente
+};
+
+#endif // RISK_ROLLUP_H
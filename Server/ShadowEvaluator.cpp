@@ -0,0 +1,128 @@
+#include "ShadowEvaluator.h"
+#include <chrono>
+
+using namespace std;
+
+// ==========================================
+// ShadowQueue Implementation
+// ==========================================
+ShadowQueue::ShadowQueue(size_t capacityPow2)
+    : cells(new Cell[capacityPow2]), mask(capacityPow2 - 1) {
+  for (size_t i = 0; i < capacityPow2; ++i)
+    cells[i].sequence.store(i, memory_order_relaxed);
+}
+
+bool ShadowQueue::tryPush(ShadowSample &&sample) {
+  size_t pos = enqueuePos.load(memory_order_relaxed);
+  Cell *cell;
+  for (;;) {
+    cell = &cells[pos & mask];
+    size_t seq = cell->sequence.load(memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                           memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return false; // lleno
+    } else {
+      pos = enqueuePos.load(memory_order_relaxed);
+    }
+  }
+  cell->sample = std::move(sample);
+  cell->sequence.store(pos + 1, memory_order_release);
+  return true;
+}
+
+bool ShadowQueue::tryPop(ShadowSample &out) {
+  size_t pos = dequeuePos.load(memory_order_relaxed);
+  Cell *cell;
+  for (;;) {
+    cell = &cells[pos & mask];
+    size_t seq = cell->sequence.load(memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (diff == 0) {
+      if (dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                           memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return false; // vacío
+    } else {
+      pos = dequeuePos.load(memory_order_relaxed);
+    }
+  }
+  out = std::move(cell->sample);
+  cell->sequence.store(pos + mask + 1, memory_order_release);
+  return true;
+}
+
+// ==========================================
+// ShadowEvaluator Implementation
+// ==========================================
+ShadowEvaluator::ShadowEvaluator(size_t queueCapacityPow2,
+                                 uint32_t sampleEvery)
+    : queue(queueCapacityPow2), sampleEvery(sampleEvery == 0 ? 1 : sampleEvery) {}
+
+ShadowEvaluator::~ShadowEvaluator() { stop(); }
+
+void ShadowEvaluator::start(Scorer candidateScorer) {
+  if (running.load())
+    return;
+  scorer = std::move(candidateScorer);
+  running.store(true);
+  worker = thread(&ShadowEvaluator::run, this);
+}
+
+void ShadowEvaluator::stop() {
+  running.store(false);
+  if (worker.joinable())
+    worker.join();
+}
+
+bool ShadowEvaluator::shouldSample() {
+  if (!running.load(memory_order_relaxed))
+    return false;
+  return requestCounter.fetch_add(1, memory_order_relaxed) % sampleEvery == 0;
+}
+
+void ShadowEvaluator::offer(ShadowSample &&sample) {
+  offered.fetch_add(1, memory_order_relaxed);
+  if (!queue.tryPush(std::move(sample)))
+    dropped.fetch_add(1, memory_order_relaxed);
+}
+
+void ShadowEvaluator::run() {
+  ShadowSample sample;
+  while (running.load(memory_order_relaxed)) {
+    if (!queue.tryPop(sample)) {
+      this_thread::sleep_for(chrono::milliseconds(2));
+      continue;
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    float candidate = scorer(sample);
+    auto ns = chrono::duration_cast<chrono::nanoseconds>(
+                  chrono::steady_clock::now() - t0)
+                  .count();
+
+    candidateNanos.fetch_add((uint64_t)ns, memory_order_relaxed);
+    primaryNanos.fetch_add((uint64_t)(sample.primaryMicros * 1000.0),
+                           memory_order_relaxed);
+    if ((candidate > 0.5f) == (sample.primaryPrediction > 0.5f))
+      agreements.fetch_add(1, memory_order_relaxed);
+    scored.fetch_add(1, memory_order_relaxed);
+  }
+}
+
+ShadowStats ShadowEvaluator::stats() const {
+  ShadowStats s;
+  s.offered = offered.load();
+  s.dropped = dropped.load();
+  s.scored = scored.load();
+  s.agreements = agreements.load();
+  if (s.scored > 0) {
+    s.meanPrimaryMicros = primaryNanos.load() / 1000.0 / s.scored;
+    s.meanCandidateMicros = candidateNanos.load() / 1000.0 / s.scored;
+  }
+  return s;
+}
@@ -0,0 +1,83 @@
+#ifndef SHADOW_EVALUATOR_H
+#define SHADOW_EVALUATOR_H
+
+#include "ZoneHistory.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Copia de una petición ya resuelta por el modelo primario.
+struct ShadowSample {
+  std::array<float, HISTORY_DAYS * HISTORY_TYPES> window; // entrada LSTM
+  std::vector<float> features; // fila del RF primario (embedding + INEC)
+  float primaryPrediction = 0.0f;
+  double primaryMicros = 0.0;
+};
+
+// --- Bounded lock-free MPMC queue (Vyukov) ---
+// tryPush never blocks: when the queue is full the sample is dropped.
+class ShadowQueue {
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    ShadowSample sample;
+  };
+  std::unique_ptr<Cell[]> cells;
+  size_t mask;
+  alignas(64) std::atomic<size_t> enqueuePos{0};
+  alignas(64) std::atomic<size_t> dequeuePos{0};
+
+public:
+  explicit ShadowQueue(size_t capacityPow2);
+  bool tryPush(ShadowSample &&sample);
+  bool tryPop(ShadowSample &out);
+};
+
+struct ShadowStats {
+  uint64_t offered = 0;
+  uint64_t dropped = 0;
+  uint64_t scored = 0;
+  uint64_t agreements = 0;
+  double meanPrimaryMicros = 0.0;
+  double meanCandidateMicros = 0.0;
+};
+
+// --- Scores sampled requests with a candidate model on a background thread ---
+// The request path only calls shouldSample() and offer(); neither waits on
+// the candidate model.
+class ShadowEvaluator {
+public:
+  // Returns the candidate's prediction for a sample.
+  using Scorer = std::function<float(ShadowSample &)>;
+
+private:
+  ShadowQueue queue;
+  Scorer scorer;
+  uint32_t sampleEvery;
+  std::atomic<uint64_t> requestCounter{0};
+  std::atomic<uint64_t> offered{0}, dropped{0}, scored{0}, agreements{0};
+  std::atomic<uint64_t> primaryNanos{0}, candidateNanos{0};
+  std::atomic<bool> running{false};
+  std::thread worker;
+
+  void run();
+
+public:
+  ShadowEvaluator(size_t queueCapacityPow2, uint32_t sampleEvery);
+  ~ShadowEvaluator();
+
+  void start(Scorer candidateScorer);
+  void stop();
+  bool enabled() const { return running.load(std::memory_order_relaxed); }
+
+  // Cheap 1-in-N sampling decision for the request path.
+  bool shouldSample();
+  void offer(ShadowSample &&sample);
+  ShadowStats stats() const;
+};
+
+#endif // SHADOW_EVALUATOR_H
@@ -0,0 +1,172 @@
+#include "ZoneHistory.h"
+#include "CsvTokenizer.h"
+#include "FieldParse.h"
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <set>
+
+using namespace std;
+
+const int ROW_FLOATS = HISTORY_TYPES;
+const int WINDOW_FLOATS = HISTORY_DAYS * HISTORY_TYPES;
+
+// Howard Hinnant's days_from_civil / civil_from_days
+int32_t fechaToDay(long fecha) {
+  int y = (int)(fecha / 10000);
+  unsigned m = (unsigned)(fecha / 100 % 100);
+  unsigned d = (unsigned)(fecha % 100);
+  y -= m <= 2;
+  const int era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = (unsigned)(y - era * 400);
+  const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+long dayToFecha(int32_t day) {
+  day += 719468;
+  const int era = (day >= 0 ? day : day - 146096) / 146097;
+  const unsigned doe = (unsigned)(day - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int y = (int)yoe + era * 400;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+  const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+  y += m <= 2;
+  return (long)y * 10000 + m * 100 + d;
+}
+
+ZoneHistoryStore::ZoneHistoryStore() : emptyWindow(WINDOW_FLOATS, 0.0f) {}
+
+void ZoneHistoryStore::setTypes(const vector<string> &types) {
+  unique_lock<shared_mutex> lock(mtx);
+  typeIds.clear();
+  for (size_t i = 0; i < types.size() && i < (size_t)HISTORY_TYPES; ++i)
+    typeIds[types[i]] = (int)i;
+}
+
+int ZoneHistoryStore::zoneIdLocked(const string &zona) {
+  auto it = zoneIds.find(zona);
+  if (it != zoneIds.end())
+    return it->second;
+  int id = (int)zoneIds.size();
+  zoneIds.emplace(zona, id);
+  rings.resize(rings.size() + RING_FLOATS, 0.0f);
+  return id;
+}
+
+// Moves every zone forward to `day`, zeroing the rows of the skipped days.
+void ZoneHistoryStore::advanceToLocked(int32_t day) {
+  if (currentDay == INT32_MIN) {
+    currentDay = day;
+    return;
+  }
+  int32_t gap = min<int32_t>(day - currentDay, HISTORY_DAYS);
+  for (size_t z = 0; z < zoneIds.size(); ++z) {
+    float *r = ring((int)z);
+    for (int32_t k = 1; k <= gap; ++k) {
+      int slot = (int)((currentDay + k) % HISTORY_DAYS);
+      fill_n(r + slot * ROW_FLOATS, ROW_FLOATS, 0.0f);
+      fill_n(r + (slot + HISTORY_DAYS) * ROW_FLOATS, ROW_FLOATS, 0.0f);
+    }
+  }
+  currentDay = day;
+}
+
+size_t ZoneHistoryStore::appendBatch(const vector<ZoneEvent> &events) {
+  unique_lock<shared_mutex> lock(mtx);
+
+  // Advance once to the newest day of the batch, then scatter the counts.
+  int32_t newest = currentDay;
+  for (const auto &e : events)
+    if (e.fecha > 0)
+      newest = max(newest, fechaToDay(e.fecha));
+  if (newest != INT32_MIN && newest != currentDay)
+    advanceToLocked(newest);
+
+  size_t applied = 0;
+  for (const auto &e : events) {
+    if (e.fecha <= 0)
+      continue;
+    auto type = typeIds.find(e.servicio);
+    if (type == typeIds.end())
+      continue;
+    int32_t day = fechaToDay(e.fecha);
+    if (day <= currentDay - HISTORY_DAYS)
+      continue; // fuera de la ventana
+
+    float *r = ring(zoneIdLocked(e.zona));
+    int slot = (int)(day % HISTORY_DAYS);
+    r[slot * ROW_FLOATS + type->second] += 1.0f;
+    r[(slot + HISTORY_DAYS) * ROW_FLOATS + type->second] += 1.0f;
+    applied++;
+  }
+  return applied;
+}
+
+bool ZoneHistoryStore::loadCsv(const string &path, int zonaCol,
+                               int servicioCol, int fechaCol) {
+  int maxCol = max(zonaCol, max(servicioCol, fechaCol));
+  vector<ZoneEvent> events;
+  bool ok = readCsvFile(path, [&](const vector<string_view> &row) {
+    if ((int)row.size() <= maxCol)
+      return;
+
+    ZoneEvent e;
+    e.zona = string(row[zonaCol]);
+    e.servicio = string(row[servicioCol]);
+    int64_t fecha;
+    if (parseInt(row[fechaCol], fecha) != ParseError::None)
+      return;
+    e.fecha = (long)fecha; // "20251001.0" -> 20251001
+    events.push_back(std::move(e));
+  });
+  if (!ok) {
+    cerr << "[WARN] No se pudo abrir eventos: " << path << endl;
+    return false;
+  }
+
+  bool needTypes;
+  {
+    shared_lock<shared_mutex> lock(mtx);
+    needTypes = typeIds.empty();
+  }
+  if (needTypes) {
+    set<string> types;
+    for (const auto &e : events)
+      types.insert(e.servicio);
+    setTypes(vector<string>(types.begin(), types.end()));
+  }
+
+  size_t applied = appendBatch(events);
+  cout << "[INFO] Historial cargado: " << applied << " eventos, "
+       << numZones() << " zonas." << endl;
+  return true;
+}
+
+bool ZoneHistoryStore::withWindow(
+    const string &zona, const function<void(const float *)> &fn) const {
+  shared_lock<shared_mutex> lock(mtx);
+  auto it = zoneIds.find(zona);
+  if (it == zoneIds.end() || currentDay == INT32_MIN) {
+    fn(emptyWindow.data());
+    return false;
+  }
+  // La ventana empieza en el día más antiguo: (currentDay + 1) % DAYS.
+  int start = (int)((currentDay + 1) % HISTORY_DAYS);
+  const float *r = rings.data() + (size_t)it->second * RING_FLOATS;
+  fn(r + start * ROW_FLOATS);
+  return true;
+}
+
+size_t ZoneHistoryStore::numZones() const {
+  shared_lock<shared_mutex> lock(mtx);
+  return zoneIds.size();
+}
+
+long ZoneHistoryStore::currentFecha() const {
+  shared_lock<shared_mutex> lock(mtx);
+  return currentDay == INT32_MIN ? 0 : dayToFecha(currentDay);
+}
@@ -0,0 +1,72 @@
+#ifndef ZONE_HISTORY_H
+#define ZONE_HISTORY_H
+
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Ventana que espera el LSTM: [30 días x 7 tipos de servicio]
+const int HISTORY_DAYS = 30;
+const int HISTORY_TYPES = 7;
+
+struct ZoneEvent {
+  std::string zona;
+  std::string servicio;
+  long fecha; // YYYYMMDD
+};
+
+// --- Rolling per-zone history of daily service counts ---
+// All zones share one contiguous float array. Each zone owns a mirrored ring
+// of 2 * HISTORY_DAYS rows: day d is written to rows (d % DAYS) and
+// (d % DAYS) + DAYS, so the last HISTORY_DAYS days are always contiguous
+// (oldest first) and can be handed to LibTorch without copying.
+// Every zone is aligned to the same "current day", so zones without recent
+// events read zeros for the missing days.
+class ZoneHistoryStore {
+private:
+  static const int RING_FLOATS = 2 * HISTORY_DAYS * HISTORY_TYPES;
+
+  std::vector<float> rings; // numZones * RING_FLOATS
+  std::unordered_map<std::string, int> zoneIds;
+  std::unordered_map<std::string, int> typeIds;
+  int32_t currentDay = INT32_MIN; // days since 1970-01-01
+  std::vector<float> emptyWindow;
+  mutable std::shared_mutex mtx;
+
+  int zoneIdLocked(const std::string &zona);
+  void advanceToLocked(int32_t day);
+  float *ring(int zoneId) { return rings.data() + (size_t)zoneId * RING_FLOATS; }
+
+public:
+  ZoneHistoryStore();
+
+  // Fixes the type -> column order (must match the LSTM training order).
+  // Only the first HISTORY_TYPES names are kept.
+  void setTypes(const std::vector<std::string> &types);
+
+  // Applies a batch under one exclusive lock. Events older than the window
+  // or with unknown types are dropped. Returns how many were applied.
+  size_t appendBatch(const std::vector<ZoneEvent> &events);
+
+  // Loads an events CSV (zona/servicio/fecha columns). If no types were set,
+  // the sorted unique service names are used, like the training pipeline.
+  bool loadCsv(const std::string &path, int zonaCol, int servicioCol,
+               int fechaCol);
+
+  // Calls fn with the zone's [DAYS x TYPES] window while holding a shared
+  // lock; unknown zones get an all-zero window and the call returns false.
+  bool withWindow(const std::string &zona,
+                  const std::function<void(const float *)> &fn) const;
+
+  size_t numZones() const;
+  long currentFecha() const; // YYYYMMDD of the newest day, 0 if empty
+};
+
+// YYYYMMDD <-> days since 1970-01-01 (proleptic Gregorian calendar)
+int32_t fechaToDay(long fecha);
+long dayToFecha(int32_t day);
+
+#endif // ZONE_HISTORY_H
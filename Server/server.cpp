@@ -1,7 +1,8 @@
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
 #include <map>
-#include <sstream>
 #include <string>
 #include <vector>
 
@@ -12,6 +13,24 @@
 #include <opencv2/opencv.hpp>
 #include <torch/torch.h>
 
+// Formato binario del bosque (mmap)
+#include "ForestFormat.h"
+#include "RTreesForest.h"
+#include "RfSchema.h"
+
+// Single-flight + caché corta de predicciones por zona
+#include "PredictionCache.h"
+
+// Historial por zona (ventana de 30 días que alimenta al LSTM)
+#include "ZoneHistory.h"
+
+// Evaluación en sombra de un modelo candidato
+#include "ShadowEvaluator.h"
+
+// Lector CSV compartido (SIMD)
+#include "CsvTokenizer.h"
+#include "FieldParse.h"
+
 using json = nlohmann::json;
 using namespace cv;
 using namespace cv::ml;
@@ -65,64 +84,261 @@ TORCH_MODULE(CrimeLSTM);
 // ==========================================
 // 2. VARIABLES GLOBALES Y CARGA DE DATOS
 // ==========================================
+const std::string MODEL_RF_PATH = "random_forest_model.xml";
+const std::string MODEL_RF_BIN = "random_forest_model.bin";
+const int EMB_DIM = 32;
+// Eventos crudos: mismas columnas que el pipeline de entrenamiento (mainV2)
+const std::string CSV_EVENTOS = "mini_datos_202112_202510_v3.csv";
+const int COL_ZONA = 3, COL_SERVICIO = 4, COL_FECHA = 6;
+
 std::map<std::string, std::vector<float>> inec_map;
+std::vector<std::string> inec_feature_names;
+FlatForest rf_forest; // Bosque plano (mmap); rf_model solo si no se convierte
 Ptr<RTrees> rf_model;
 CrimeLSTM lstm_model(nullptr); // Se inicializa luego
 bool models_loaded = false;
 
+// Versión del snapshot de datos: cambia con cada lote de /events,
+// e invalida la caché de predicciones (forma parte de la clave).
+std::atomic<uint64_t> snapshot_version{1};
+
+ZoneHistoryStore zone_history;
+
+// Modelo candidato (opcional): TH_CANDIDATE_RF (.bin o .xml) y/o
+// TH_CANDIDATE_LSTM (.pt). Se muestrea 1 de cada TH_SHADOW_SAMPLE
+// predicciones calculadas.
+FlatForest candidate_forest;
+Ptr<RTrees> candidate_rf;
+CrimeLSTM candidate_lstm(nullptr);
+uint32_t shadow_sample_from_env() {
+  const char *env = std::getenv("TH_SHADOW_SAMPLE");
+  long n = env ? std::atol(env) : 10;
+  return n < 1 ? 1 : (uint32_t)n;
+}
+ShadowEvaluator shadow(1024, shadow_sample_from_env());
+
+// TTL de la caché en ms (TH_CACHE_TTL_MS, 0 = solo coalescing)
+std::chrono::milliseconds cache_ttl_from_env() {
+  const char *env = std::getenv("TH_CACHE_TTL_MS");
+  long ms = env ? std::atol(env) : 2000;
+  return std::chrono::milliseconds(ms < 0 ? 0 : ms);
+}
+PredictionCache prediction_cache(cache_ttl_from_env());
+
 // Cargar datos estáticos (INEC)
 void load_inec_data(const std::string &path) {
-  std::ifstream file(path);
-  if (!file.is_open()) {
+  std::vector<std::string> header;
+  bool ok = readCsvFile(
+      path,
+      [](const std::vector<std::string_view> &row) {
+        if (row.size() < 3)
+          return;
+
+        // Asumiendo col 0 es ID, col 2 en adelante son features
+        std::vector<float> feats(row.size() - 2);
+        parseFloatColumn(row.data() + 2, feats.size(), feats.data());
+        inec_map[std::string(row[0])] = feats;
+      },
+      &header);
+  if (!ok) {
     std::cerr << "Error cargando INEC: " << path << std::endl;
     return;
   }
-  std::string line, cell;
-  std::getline(file, line); // header
-  while (std::getline(file, line)) {
-    std::stringstream ss(line);
-    std::vector<std::string> row;
-    while (std::getline(ss, cell, ','))
-      row.push_back(cell);
-    if (row.size() < 3)
-      continue;
-
-    std::vector<float> feats;
-    // Asumiendo col 0 es ID, col 2 en adelante son features
-    for (size_t i = 2; i < row.size(); ++i) {
-      try {
-        feats.push_back(std::stof(row[i]));
-      } catch (...) {
-        feats.push_back(0.0f);
-      }
-    }
-    inec_map[row[0]] = feats;
-  }
+  if (header.size() > 2)
+    inec_feature_names.assign(header.begin() + 2, header.end());
   std::cout << "INEC Data cargada: " << inec_map.size() << " zonas."
             << std::endl;
 }
 
+// Carga el bosque: .bin por mmap o, como respaldo, importa el XML y
+// regenera el .bin para el próximo arranque (solo si el XML usa uno de los
+// esquemas conocidos: embeddings, o embeddings + INEC).
+void load_random_forest() {
+  if (loadRfForest(rf_forest, MODEL_RF_BIN, EMB_DIM, inec_feature_names)) {
+    std::cout << "Random Forest binario cargado (" << rf_forest.numTrees()
+              << " arboles)." << std::endl;
+    return;
+  }
+
+  rf_model = RTrees::load(MODEL_RF_PATH);
+  if (rf_model.empty())
+    throw std::runtime_error("No se pudo cargar XML de RF");
+  std::cout << "Random Forest (OpenCV) cargado desde XML." << std::endl;
+
+  std::vector<std::string> schema =
+      rfTrainedSchema(rf_model->getVarCount(), EMB_DIM, inec_feature_names);
+  if (schema.empty()) {
+    std::cerr << "El XML usa " << rf_model->getVarCount()
+              << " features, que no coinciden con el esquema; no se exporta "
+              << MODEL_RF_BIN << std::endl;
+    return;
+  }
+  ForestBuilder builder;
+  if (forestFromRTrees(rf_model, schema.size(), builder) &&
+      rf_forest.adopt(
+          builder.serialize(schema.size(), forestSchemaHash(schema)))) {
+    if (rf_forest.save(MODEL_RF_BIN))
+      std::cout << "Bosque exportado a " << MODEL_RF_BIN << std::endl;
+    rf_model.release();
+  }
+}
+
+// El modelo lee solo sus primeras columnas; la fila del llamador no se
+// modifica (la sombra la necesita completa). Si es más corta, se rellena
+// una copia con ceros.
+float predict_rf(const std::vector<float> &features) {
+  size_t n = !rf_forest.empty() ? rf_forest.numFeatures()
+                                : (size_t)rf_model->getVarCount();
+  const float *row = features.data();
+  std::vector<float> padded;
+  if (features.size() < n) {
+    padded = features;
+    padded.resize(n, 0.0f);
+    row = padded.data();
+  }
+  if (!rf_forest.empty())
+    return rf_forest.predict(row);
+  cv::Mat sample(1, (int)n, CV_32F, const_cast<float *>(row));
+  return rf_model->predict(sample);
+}
+
+// Inferencia completa (LSTM + RF) de una zona. Se ejecuta una sola vez por
+// zona y snapshot aunque lleguen muchas peticiones iguales a la vez.
+float predict_zone(const std::string &zona) {
+  torch::NoGradGuard no_grad;
+  auto t0 = std::chrono::steady_clock::now();
+  bool sampled = shadow.shouldSample();
+  ShadowSample shadow_sample;
+
+  // --- PASO 1: INFERENCIA LSTM ---
+  // Input: [Batch=1, Timesteps=30, Features=7], vista sin copia sobre el
+  // anillo de historial de la zona (válida mientras dure el lock compartido).
+  // La copia para la sombra se hace bajo el mismo lock (misma ventana que
+  // ve el primario) pero se descuenta de su latencia.
+  std::vector<float> lstm_feats(EMB_DIM);
+  std::chrono::steady_clock::duration shadow_copy_time{};
+  zone_history.withWindow(zona, [&](const float *window) {
+    if (sampled) {
+      auto c0 = std::chrono::steady_clock::now();
+      std::copy(window, window + shadow_sample.window.size(),
+                shadow_sample.window.begin());
+      shadow_copy_time = std::chrono::steady_clock::now() - c0;
+    }
+    auto input_tensor =
+        torch::from_blob(const_cast<float *>(window),
+                         {1, HISTORY_DAYS, HISTORY_TYPES}, torch::kFloat32);
+
+    // Embedding latente (lo que "piensa" el LSTM sobre el futuro) [1, 32]
+    auto embedding_tensor =
+        lstm_model->get_embedding(input_tensor).contiguous();
+    const float *ptr = embedding_tensor.data_ptr<float>();
+    std::copy(ptr, ptr + EMB_DIM, lstm_feats.begin());
+  });
+
+  // --- PASO 2: BUSCAR DATOS INEC ---
+  std::vector<float> inec_feats;
+  if (inec_map.count(zona)) {
+    inec_feats = inec_map.at(zona);
+  } else {
+    // Zona desconocida: rellenar con ceros
+    inec_feats.resize(inec_map.begin()->second.size(), 0.0f);
+  }
+
+  // --- PASO 3: FUSIÓN DE VECTORES ---
+  std::vector<float> final_features = lstm_feats;
+  final_features.insert(final_features.end(), inec_feats.begin(),
+                        inec_feats.end());
+
+  // --- PASO 4: INFERENCIA RANDOM FOREST ---
+  float prediccion = predict_rf(final_features);
+  auto primary_time =
+      std::chrono::steady_clock::now() - t0 - shadow_copy_time;
+
+  // Copia para el modelo en sombra; nunca bloquea (si la cola está llena,
+  // la muestra se descarta).
+  if (sampled) {
+    shadow_sample.features = final_features;
+    shadow_sample.primaryPrediction = prediccion;
+    shadow_sample.primaryMicros =
+        std::chrono::duration<double, std::micro>(primary_time).count();
+    shadow.offer(std::move(shadow_sample));
+  }
+  return prediccion;
+}
+
+// Carga el candidato si está configurado y arranca el hilo de sombra.
+void start_shadow_evaluation() {
+  const char *rf_path = std::getenv("TH_CANDIDATE_RF");
+  const char *lstm_path = std::getenv("TH_CANDIDATE_LSTM");
+  if (!rf_path && !lstm_path)
+    return;
+
+  if (rf_path) {
+    std::string path = rf_path;
+    bool is_xml = path.size() > 4 && path.substr(path.size() - 4) == ".xml";
+    if (is_xml ||
+        !loadRfForest(candidate_forest, path, EMB_DIM, inec_feature_names)) {
+      candidate_rf = RTrees::load(path);
+      if (candidate_rf.empty())
+        throw std::runtime_error("No se pudo cargar RF candidato: " + path);
+    }
+  }
+  if (lstm_path) {
+    candidate_lstm = CrimeLSTM(HISTORY_TYPES, EMB_DIM);
+    torch::load(candidate_lstm, lstm_path);
+    candidate_lstm->eval();
+  }
+
+  shadow.start([](ShadowSample &sample) {
+    torch::NoGradGuard no_grad;
+    std::vector<float> &row = sample.features;
+    if (!candidate_lstm.is_empty()) {
+      auto input = torch::from_blob(sample.window.data(),
+                                    {1, HISTORY_DAYS, HISTORY_TYPES},
+                                    torch::kFloat32);
+      auto emb = candidate_lstm->get_embedding(input).contiguous();
+      const float *ptr = emb.data_ptr<float>();
+      std::copy(ptr, ptr + EMB_DIM, row.begin());
+    }
+    if (!candidate_forest.empty()) {
+      row.resize(candidate_forest.numFeatures(), 0.0f);
+      return candidate_forest.predict(row.data());
+    }
+    if (!candidate_rf.empty()) {
+      row.resize(candidate_rf->getVarCount(), 0.0f);
+      cv::Mat sample_mat(1, row.size(), CV_32F, row.data());
+      return candidate_rf->predict(sample_mat);
+    }
+    return predict_rf(row); // solo cambia el LSTM
+  });
+  std::cout << "Evaluacion en sombra activa (1 de cada "
+            << shadow_sample_from_env() << " predicciones)." << std::endl;
+}
+
 int main() {
   std::cout << "--- Iniciando Servidor TouristHelper (Híbrido) ---"
             << std::endl;
 
   // A. CARGAR MODELOS
   try {
-    // 1. Cargar RF (OpenCV)
-    rf_model = RTrees::load("random_forest_model.xml");
-    if (rf_model.empty())
-      throw std::runtime_error("No se pudo cargar XML de RF");
-    std::cout << "Random Forest (OpenCV) cargado." << std::endl;
+    // 1. Cargar Mapa INEC (define el esquema de features del RF)
+    load_inec_data("datos_202510_ciudades_unicas_rf.csv");
 
-    // 2. Cargar LSTM (LibTorch)
+    // 2. Cargar RF (.bin por mmap, XML como respaldo)
+    load_random_forest();
+
+    // 3. Cargar LSTM (LibTorch)
     // Nota: Asumimos input_dim=7 (servicios) y emb_dim=32 como en main.cpp
-    lstm_model = CrimeLSTM(7, 32);
+    lstm_model = CrimeLSTM(7, EMB_DIM);
     torch::load(lstm_model, "lstm_checkpoint.pt");
     lstm_model->eval(); // Modo inferencia
     std::cout << "LSTM (LibTorch) cargado." << std::endl;
 
-    // 3. Cargar Mapa INEC
-    load_inec_data("datos_202510_ciudades_unicas_rf.csv");
+    // 4. Historial por zona desde el CSV de eventos
+    zone_history.loadCsv(CSV_EVENTOS, COL_ZONA, COL_SERVICIO, COL_FECHA);
+
+    // 5. Modelo candidato en sombra (opcional)
+    start_shadow_evaluation();
 
     models_loaded = true;
   } catch (const std::exception &e) {
@@ -148,43 +364,8 @@ int main() {
       return;
     }
 
-    // --- PASO 1: INFERENCIA LSTM ---
-    // En un caso real, aquí consultarías a tu DB los últimos 30 días de esa
-    // zona. Como este es un demo, generaremos un tensor "dummy" o aleatorio
-    // simulando la historia. Input: [Batch=1, Timesteps=30, Features=7]
-    auto input_tensor = torch::rand({1, 30, 7});
-
-    // Obtenemos el embedding latente (lo que "piensa" el LSTM sobre el futuro)
-    auto embedding_tensor = lstm_model->get_embedding(input_tensor); // [1, 32]
-
-    // Convertir tensor a vector std::vector
-    std::vector<float> lstm_feats(32);
-    float *ptr = embedding_tensor.data_ptr<float>();
-    for (int i = 0; i < 32; ++i)
-      lstm_feats[i] = ptr[i];
-
-    // --- PASO 2: BUSCAR DATOS INEC ---
-    std::vector<float> inec_feats;
-    if (inec_map.count(zona)) {
-      inec_feats = inec_map[zona];
-    } else {
-      // Zona desconocida: rellenar con ceros
-      inec_feats.resize(inec_map.begin()->second.size(), 0.0f);
-    }
-
-    // --- PASO 3: FUSIÓN DE VECTORES ---
-    std::vector<float> final_features = lstm_feats;
-    final_features.insert(final_features.end(), inec_feats.begin(),
-                          inec_feats.end());
-
-    // --- PASO 4: INFERENCIA RANDOM FOREST ---
-    // OpenCV espera una Matriz CV_32F
-    cv::Mat sample(1, final_features.size(), CV_32F);
-    for (size_t i = 0; i < final_features.size(); ++i) {
-      sample.at<float>(0, i) = final_features[i];
-    }
-
-    float prediccion = rf_model->predict(sample);
+    float prediccion = prediction_cache.getOrCompute(
+        zona, snapshot_version.load(), [&] { return predict_zone(zona); });
 
     // --- PASO 5: RESPUESTA JSON ---
     json response;
@@ -198,6 +379,81 @@ int main() {
     res.set_content(response.dump(), "application/json");
   });
 
+  // Endpoint: POST /events
+  // Body: [{"zona": "...", "servicio": "...", "fecha": 20251001}, ...]
+  // (o {"events": [...]}). Se aplica como un solo lote.
+  svr.Post("/events", [&](const httplib::Request &req,
+                          httplib::Response &res) {
+    json body = json::parse(req.body, nullptr, false);
+    if (body.is_object() && body.contains("events"))
+      body = body["events"];
+    if (!body.is_array()) {
+      res.status = 400;
+      res.set_content("Se esperaba un arreglo de eventos", "text/plain");
+      return;
+    }
+
+    std::vector<ZoneEvent> batch;
+    batch.reserve(body.size());
+    for (const auto &item : body) {
+      if (!item.is_object() || !item.contains("zona") ||
+          !item.contains("servicio") || !item.contains("fecha"))
+        continue;
+      const auto &fecha = item["fecha"];
+      ZoneEvent e;
+      e.zona = item["zona"].is_string() ? item["zona"].get<std::string>() : "";
+      e.servicio = item["servicio"].is_string()
+                       ? item["servicio"].get<std::string>()
+                       : "";
+      e.fecha = fecha.is_number()   ? fecha.get<long>()
+                : fecha.is_string() ? std::atol(fecha.get<std::string>().c_str())
+                                    : 0;
+      if (!e.zona.empty())
+        batch.push_back(std::move(e));
+    }
+
+    size_t aplicados = zone_history.appendBatch(batch);
+    if (aplicados > 0)
+      snapshot_version++;
+
+    json response;
+    response["recibidos"] = body.size();
+    response["aplicados"] = aplicados;
+    response["snapshot_version"] = snapshot_version.load();
+    res.set_header("Access-Control-Allow-Origin", "*");
+    res.set_content(response.dump(), "application/json");
+  });
+
+  // Endpoint: /metrics (contadores de la caché de predicciones)
+  svr.Get("/metrics", [&](const httplib::Request &, httplib::Response &res) {
+    CacheStats stats = prediction_cache.stats();
+    json metrics;
+    metrics["snapshot_version"] = snapshot_version.load();
+    if (shadow.enabled()) {
+      ShadowStats sh = shadow.stats();
+      metrics["shadow"]["ofrecidas"] = sh.offered;
+      metrics["shadow"]["descartadas"] = sh.dropped;
+      metrics["shadow"]["evaluadas"] = sh.scored;
+      metrics["shadow"]["tasa_acuerdo"] =
+          sh.scored ? (double)sh.agreements / sh.scored : 0.0;
+      metrics["shadow"]["latencia_primario_us"] = sh.meanPrimaryMicros;
+      metrics["shadow"]["latencia_candidato_us"] = sh.meanCandidateMicros;
+      metrics["shadow"]["delta_latencia_us"] =
+          sh.meanCandidateMicros - sh.meanPrimaryMicros;
+    }
+    metrics["history"]["zonas"] = zone_history.numZones();
+    metrics["history"]["ultima_fecha"] = zone_history.currentFecha();
+    metrics["cache"]["ttl_ms"] = prediction_cache.timeToLive().count();
+    metrics["cache"]["hits"] = stats.hits;
+    metrics["cache"]["misses"] = stats.misses;
+    metrics["cache"]["coalesced"] = stats.coalesced;
+    metrics["cache"]["evictions"] = stats.evictions;
+    metrics["cache"]["entries"] = stats.entries;
+
+    res.set_header("Access-Control-Allow-Origin", "*");
+    res.set_content(metrics.dump(), "application/json");
+  });
+
   std::cout << "Servidor corriendo en http://localhost:8080" << std::endl;
   svr.listen("0.0.0.0", 8080);
 
@@ -1,9 +1,10 @@
 #include <algorithm>
-#include <fstream>
+#include <cstdlib>
 #include <iostream>
 #include <map>
-#include <sstream>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 // Solo necesitamos OpenCV para el Random Forest
@@ -14,6 +15,19 @@
 #include "httplib.h"
 #include "json.hpp"
 
+// Formato binario del bosque y de los embeddings (mmap)
+#include "EmbeddingStore.h"
+#include "ForestFormat.h"
+#include "RTreesForest.h"
+#include "RfSchema.h"
+
+// Agregados por provincia / nacional
+#include "RiskRollup.h"
+
+// Lector CSV compartido (SIMD)
+#include "CsvTokenizer.h"
+#include "FieldParse.h"
+
 using json = nlohmann::json;
 using namespace cv;
 using namespace cv::ml;
@@ -22,9 +36,15 @@ using namespace cv::ml;
 // CONFIGURACIÓN
 // ==========================================
 const std::string MODEL_RF_PATH = "random_forest_model.xml";
+const std::string MODEL_RF_BIN = "random_forest_model.bin";
 const std::string CSV_EMBEDDINGS = "embeddings_lstm_gpu.csv";
+const std::string EMBEDDINGS_BIN = "embeddings_lstm.bin";
 const std::string CSV_INEC = "datos_202510_ciudades_unicas_RF.csv";
+const std::string JSON_ZONAS =
+    "../frontend/crime-risk-dashboard/src/zonas_mapeadas.json";
 const int EMB_DIM = 32;
+const size_t TOP_K_PROVINCIA = 5;
+const size_t TOP_K_DEFAULT = 10;
 
 // ==========================================
 // ESTRUCTURAS DE DATOS EN MEMORIA
@@ -40,95 +60,198 @@ std::map<std::string, std::vector<float>> embedding_cache;
 std::map<std::string, long>
     latest_date_cache; // Para asegurar que usamos la fecha más nueva
 
+// Nombres de las columnas INEC (features) en el orden del CSV
+std::vector<std::string> inec_feature_names;
+
+// Bosque plano (mmap). Si el XML no se puede convertir, se usa rf_model.
+FlatForest rf_forest;
 Ptr<RTrees> rf_model;
 bool system_ready = false;
 
+// Provincia -> cantones, y agregados del snapshot actual
+std::vector<CantonInfo> canton_membership;
+std::shared_ptr<const RiskSnapshot> risk_snapshot;
+
 // ==========================================
 // FUNCIONES DE CARGA
 // ==========================================
 
 void load_inec(const std::string &path) {
-  std::ifstream file(path);
-  if (!file.is_open()) {
+  std::vector<std::string> header;
+  bool ok = readCsvFile(
+      path,
+      [](const std::vector<std::string_view> &row) {
+        if (row.size() < 3)
+          return;
+
+        // Asumiendo formato: ID, Nombre, Feat1, Feat2...
+        std::vector<float> feats(row.size() - 2);
+        parseFloatColumn(row.data() + 2, feats.size(), feats.data());
+        inec_cache[std::string(row[0])] = feats; // row[0] es la Zona ID/Nombre
+      },
+      &header);
+  if (!ok) {
     std::cerr << "[WARN] No se pudo abrir INEC: " << path << std::endl;
     return;
   }
-  std::string line, cell;
-  std::getline(file, line); // Header
-  while (std::getline(file, line)) {
-    std::stringstream ss(line);
-    std::vector<std::string> row;
-    while (std::getline(ss, cell, ','))
-      row.push_back(cell);
-    if (row.size() < 3)
-      continue;
-
-    std::vector<float> feats;
-    // Asumiendo formato: ID, Nombre, Feat1, Feat2...
-    for (size_t i = 2; i < row.size(); ++i) {
-      try {
-        feats.push_back(std::stof(row[i]));
-      } catch (...) {
-        feats.push_back(0.0f);
-      }
-    }
-    inec_cache[row[0]] = feats; // row[0] es la Zona ID/Nombre
-  }
+  if (header.size() > 2)
+    inec_feature_names.assign(header.begin() + 2, header.end());
   std::cout << "[INFO] INEC Cache cargado: " << inec_cache.size() << " zonas."
             << std::endl;
 }
 
-void load_embeddings_lookup(const std::string &path) {
-  std::ifstream file(path);
-  if (!file.is_open()) {
-    std::cerr << "[ERROR] No se pudo abrir Embeddings CSV: " << path
-              << std::endl;
-    return;
+// Store binario que escribe el entrenador: ya trae el embedding más reciente
+// de cada zona, así que solo se copia (sin parsear texto).
+bool load_embeddings_store(const std::string &path) {
+  EmbeddingStore store;
+  if (!store.load(path, EMB_DIM))
+    return false;
+  for (uint32_t z = 0; z < store.numZones(); ++z) {
+    if (store.latestFecha(z) < 0)
+      continue;
+    std::string zona = store.zoneName(z);
+    embedding_cache[zona].assign(store.latest(z), store.latest(z) + EMB_DIM);
+    latest_date_cache[zona] = (long)store.latestFecha(z);
   }
-  std::string line, cell;
-  std::getline(file, line); // Header: zona,fecha,emb_1...emb_32,target
-
-  int loaded_count = 0;
-  while (std::getline(file, line)) {
-    std::stringstream ss(line);
-    std::vector<std::string> row;
-    while (std::getline(ss, cell, ','))
-      row.push_back(cell);
+  std::cout << "[INFO] Embeddings binarios cargados: " << embedding_cache.size()
+            << " zonas (" << store.numHistory() << " filas de historial)."
+            << std::endl;
+  return true;
+}
 
+void load_embeddings_lookup(const std::string &path) {
+  // Header: zona,fecha,emb_1...emb_32,target
+  bool ok = readCsvFile(path, [](const std::vector<std::string_view> &row) {
     // Validación mínima: Zona + Fecha + 32 Embs + Target = 35 cols
     if (row.size() < (2 + EMB_DIM))
-      continue;
+      return;
 
-    std::string zona = row[0];
-    long fecha = 0;
-    try {
-      fecha = std::stol(row[1]);
-    } catch (...) {
-    }
+    std::string zona(row[0]);
+    int64_t fecha = 0;
+    parseInt(row[1], fecha);
 
     // Lógica: Solo guardamos si es la fecha más reciente que hemos visto para
     // esta zona
-    if (latest_date_cache.find(zona) == latest_date_cache.end() ||
-        fecha >= latest_date_cache[zona]) {
-
-      std::vector<float> embs;
-      for (int i = 0; i < EMB_DIM; ++i) {
-        try {
-          embs.push_back(std::stof(row[2 + i]));
-        } catch (...) {
-          embs.push_back(0.0f);
-        }
-      }
+    auto latest = latest_date_cache.find(zona);
+    if (latest == latest_date_cache.end() || fecha >= latest->second) {
+      std::vector<float> embs(EMB_DIM);
+      parseFloatColumn(row.data() + 2, EMB_DIM, embs.data());
 
       embedding_cache[zona] = embs;
       latest_date_cache[zona] = fecha;
-      loaded_count++;
     }
+  });
+  if (!ok) {
+    std::cerr << "[ERROR] No se pudo abrir Embeddings CSV: " << path
+              << std::endl;
+    return;
   }
   std::cout << "[INFO] Embeddings Lookup cargado: " << embedding_cache.size()
             << " zonas únicas actualizadas." << std::endl;
 }
 
+// Carga el bosque: primero el .bin por mmap; si no existe o el esquema no
+// coincide, importa el XML (lento) y regenera el .bin para el próximo
+// arranque. Solo se exporta si el XML se entrenó con uno de los esquemas
+// conocidos (embeddings, o embeddings + INEC); si no, se usa tal cual.
+bool load_random_forest() {
+  if (loadRfForest(rf_forest, MODEL_RF_BIN, EMB_DIM, inec_feature_names)) {
+    std::cout << "[INFO] Random Forest binario cargado (" << rf_forest.numTrees()
+              << " arboles, " << rf_forest.numNodes() << " nodos)."
+              << std::endl;
+    return true;
+  }
+
+  try {
+    rf_model = RTrees::load(MODEL_RF_PATH);
+  } catch (const cv::Exception &e) {
+    std::cerr << "[CRITICAL] Error cargando XML: " << e.what() << std::endl;
+    return false;
+  }
+  if (rf_model.empty()) {
+    std::cerr << "[CRITICAL] Modelo RF vacio o no encontrado" << std::endl;
+    return false;
+  }
+  std::cout << "[INFO] Modelo Random Forest cargado desde XML." << std::endl;
+
+  std::vector<std::string> schema =
+      rfTrainedSchema(rf_model->getVarCount(), EMB_DIM, inec_feature_names);
+  if (schema.empty()) {
+    std::cerr << "[WARN] El XML usa " << rf_model->getVarCount()
+              << " features, que no coinciden con el esquema; no se exporta "
+              << MODEL_RF_BIN << std::endl;
+    return true;
+  }
+  ForestBuilder builder;
+  if (forestFromRTrees(rf_model, schema.size(), builder) &&
+      rf_forest.adopt(
+          builder.serialize(schema.size(), forestSchemaHash(schema)))) {
+    if (rf_forest.save(MODEL_RF_BIN))
+      std::cout << "[INFO] Bosque exportado a " << MODEL_RF_BIN << std::endl;
+    rf_model.release();
+  }
+  return true;
+}
+
+float predict_rf(std::vector<float> &features) {
+  if (!rf_forest.empty()) {
+    features.resize(rf_forest.numFeatures(), 0.0f);
+    return rf_forest.predict(features.data());
+  }
+  features.resize(rf_model->getVarCount(), 0.0f);
+  cv::Mat sample(1, features.size(), CV_32F, features.data());
+  return rf_model->predict(sample);
+}
+
+// Fila del RF para una zona: embedding más reciente + INEC (ceros si falta).
+// La zona debe existir en embedding_cache.
+std::vector<float> build_features(const std::string &zona) {
+  std::vector<float> final_features = embedding_cache.at(zona);
+
+  auto inec = inec_cache.find(zona);
+  if (inec != inec_cache.end()) {
+    final_features.insert(final_features.end(), inec->second.begin(),
+                          inec->second.end());
+  } else {
+    // Relleno seguro si falta INEC
+    size_t n = inec_cache.empty() ? 5 : inec_cache.begin()->second.size();
+    final_features.resize(final_features.size() + n, 0.0f);
+  }
+  return final_features;
+}
+
+// Puntúa todos los cantones conocidos una sola vez por snapshot.
+void build_risk_snapshot() {
+  long fecha_max = 0;
+  for (const auto &entry : latest_date_cache)
+    fecha_max = std::max(fecha_max, entry.second);
+
+  std::unordered_map<std::string, std::string> zonas_por_nombre;
+  for (const auto &entry : embedding_cache)
+    zonas_por_nombre.emplace(normalizeZoneName(entry.first), entry.first);
+
+  auto scorer = [&](const CantonInfo &c, CantonScore &out) {
+    auto it = zonas_por_nombre.find(c.canton);
+    if (it == zonas_por_nombre.end())
+      return false;
+    std::vector<float> feats = build_features(it->second);
+    float prediccion = predict_rf(feats);
+    out.alto = prediccion > 0.5f;
+    // Con el bosque plano el score es la fracción de votos "alto riesgo";
+    // con RTrees solo tenemos la clase.
+    out.score = rf_forest.empty() ? (out.alto ? 1.0f : 0.0f)
+                                  : rf_forest.voteShare(feats.data(), 1.0f);
+    return true;
+  };
+
+  auto snap = RiskSnapshot::build(canton_membership, scorer, TOP_K_PROVINCIA,
+                                  fecha_max);
+  std::atomic_store(&risk_snapshot, snap);
+  std::cout << "[INFO] Snapshot de riesgo: " << snap->numScored()
+            << " cantones en " << snap->numProvinces() << " provincias."
+            << std::endl;
+}
+
 // ==========================================
 // MAIN SERVER
 // ==========================================
@@ -137,20 +260,14 @@ int main() {
   std::cout << "--- Iniciando Servidor (Modo Lookup/Clasificación) ---"
             << std::endl;
 
-  // 1. Cargar Random Forest (Cerebro de decisión)
-  try {
-    rf_model = RTrees::load(MODEL_RF_PATH);
-    if (rf_model.empty())
-      throw std::runtime_error("Modelo RF vacio o no encontrado");
-    std::cout << "[INFO] Modelo Random Forest cargado." << std::endl;
-  } catch (const cv::Exception &e) {
-    std::cerr << "[CRITICAL] Error cargando XML: " << e.what() << std::endl;
-    return -1;
-  }
-
-  // 2. Cargar Datos en Memoria
+  // 1. Cargar Datos en Memoria (el esquema INEC define el hash del modelo)
   load_inec(CSV_INEC);
-  load_embeddings_lookup(CSV_EMBEDDINGS);
+  if (!load_embeddings_store(EMBEDDINGS_BIN))
+    load_embeddings_lookup(CSV_EMBEDDINGS);
+
+  // 2. Cargar Random Forest (Cerebro de decisión)
+  if (!load_random_forest())
+    return -1;
 
   if (embedding_cache.empty()) {
     std::cerr << "[CRITICAL] No se cargaron embeddings. El servidor no puede "
@@ -159,6 +276,10 @@ int main() {
     return -1;
   }
 
+  // 3. Agregados por provincia (una vez por snapshot)
+  canton_membership = loadCantonMembership(JSON_ZONAS);
+  build_risk_snapshot();
+
   system_ready = true;
   httplib::Server svr;
 
@@ -191,33 +312,13 @@ int main() {
       return;
     }
 
-    std::vector<float> lstm_feats = embedding_cache[zona];
     long fecha_dato = latest_date_cache[zona];
 
-    // --- PASO B: BUSCAR INEC ---
-    std::vector<float> inec_feats;
-    if (inec_cache.count(zona)) {
-      inec_feats = inec_cache[zona];
-    } else {
-      // Relleno seguro si falta INEC
-      if (!inec_cache.empty())
-        inec_feats.resize(inec_cache.begin()->second.size(), 0.0f);
-      else
-        inec_feats.resize(5, 0.0f);
-    }
-
-    // --- PASO C: FUSIÓN ---
-    std::vector<float> final_features = lstm_feats;
-    final_features.insert(final_features.end(), inec_feats.begin(),
-                          inec_feats.end());
+    // --- PASO B/C: INEC + FUSIÓN ---
+    std::vector<float> final_features = build_features(zona);
 
     // --- PASO D: CLASIFICACIÓN RF ---
-    cv::Mat sample(1, final_features.size(), CV_32F);
-    for (size_t i = 0; i < final_features.size(); ++i) {
-      sample.at<float>(0, i) = final_features[i];
-    }
-
-    float prediccion = rf_model->predict(sample);
+    float prediccion = predict_rf(final_features);
 
     // --- RESPUESTA ---
     json response;
@@ -234,6 +335,35 @@ int main() {
     res.set_content(response.dump(), "application/json");
   });
 
+  // Endpoint: /province/GUAYAS
+  svr.Get("/province/:name",
+          [&](const httplib::Request &req, httplib::Response &res) {
+            auto snap = std::atomic_load(&risk_snapshot);
+            const std::string *body =
+                snap ? snap->province(req.path_params.at("name")) : nullptr;
+            res.set_header("Access-Control-Allow-Origin", "*");
+            if (!body) {
+              json err;
+              err["error"] = "Provincia desconocida.";
+              res.status = 404;
+              res.set_content(err.dump(), "application/json");
+              return;
+            }
+            res.set_content(*body, "application/json");
+          });
+
+  // Endpoint: /top?k=10 (cantones más riesgosos + agregado nacional)
+  svr.Get("/top", [&](const httplib::Request &req, httplib::Response &res) {
+    size_t k = TOP_K_DEFAULT;
+    if (req.has_param("k")) {
+      long pedido = std::atol(req.get_param_value("k").c_str());
+      k = pedido > 0 ? (size_t)pedido : TOP_K_DEFAULT;
+    }
+    auto snap = std::atomic_load(&risk_snapshot);
+    res.set_header("Access-Control-Allow-Origin", "*");
+    res.set_content(snap ? snap->top(k) : "{}", "application/json");
+  });
+
   std::cout << "Servidor escuchando en http://localhost:8080" << std::endl;
   svr.listen("0.0.0.0", 8080);
 
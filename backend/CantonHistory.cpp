@@ -0,0 +1,67 @@
+#include "CantonHistory.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+CantonHistories buildCantonHistories(const arma::fmat &data, size_t cantonRow,
+                                     const arma::Row<size_t> &labels,
+                                     size_t numThreads) {
+  CantonHistories h;
+  const size_t n = data.n_cols;
+  h.offsets.push_back(0);
+  if (n == 0)
+    return h;
+
+  if (numThreads == 0)
+    numThreads = defaultThreadCount();
+  const size_t numChunks = min(numThreads, n);
+  auto chunkBegin = [&](size_t c) { return c * n / numChunks; };
+  auto codeOf = [&](size_t i) { return (int32_t)data(cantonRow, i); };
+
+  // Codes are small (provId * 1000 + localId), so they index a flat table.
+  vector<int32_t> chunkMin(numChunks, INT32_MAX), chunkMax(numChunks, INT32_MIN);
+  parallelFor(numChunks, numThreads, [&](size_t c) {
+    for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i) {
+      chunkMin[c] = min(chunkMin[c], codeOf(i));
+      chunkMax[c] = max(chunkMax[c], codeOf(i));
+    }
+  });
+  const int32_t minCode = *min_element(chunkMin.begin(), chunkMin.end());
+  const size_t range =
+      (size_t)(*max_element(chunkMax.begin(), chunkMax.end()) - minCode) + 1;
+
+  // 1. Counting pass: rows per (chunk, code).
+  vector<size_t> counts(numChunks * range, 0);
+  parallelFor(numChunks, numThreads, [&](size_t c) {
+    size_t *row = counts.data() + c * range;
+    for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i)
+      row[codeOf(i) - minCode]++;
+  });
+
+  // 2. Prefix sum: a dense id for each code present, and each chunk's first
+  //    slot inside every canton (earlier chunks come first, keeping row
+  //    order). `counts` is overwritten with those cursors.
+  for (size_t code = 0; code < range; ++code) {
+    size_t total = 0;
+    for (size_t c = 0; c < numChunks; ++c) {
+      size_t cnt = counts[c * range + code];
+      counts[c * range + code] = h.offsets.back() + total;
+      total += cnt;
+    }
+    if (total == 0)
+      continue;
+    h.cantonCode.push_back((int32_t)code + minCode);
+    h.offsets.push_back(h.offsets.back() + total);
+  }
+
+  // 3. Parallel fill into disjoint slots.
+  h.values.resize(n);
+  parallelFor(numChunks, numThreads, [&](size_t c) {
+    size_t *cursor = counts.data() + c * range;
+    for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i)
+      h.values[cursor[codeOf(i) - minCode]++] = (float)labels(i);
+  });
+  return h;
+}
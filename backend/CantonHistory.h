@@ -0,0 +1,30 @@
+#ifndef CANTON_HISTORY_H
+#define CANTON_HISTORY_H
+
+#include <armadillo>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- Per-canton label histories in CSR form ---
+// Cantons get dense ids in ascending canton-code order; the labels of dense
+// canton c are values[offsets[c] .. offsets[c + 1]), in row order.
+struct CantonHistories {
+  std::vector<int32_t> cantonCode; // dense id -> canton code
+  std::vector<size_t> offsets;     // numCantons() + 1 entries
+  std::vector<float> values;
+
+  size_t numCantons() const { return cantonCode.size(); }
+  size_t length(size_t c) const { return offsets[c + 1] - offsets[c]; }
+  const float *history(size_t c) const { return values.data() + offsets[c]; }
+};
+
+// Groups labels by the canton code in row `cantonRow` of `data` (one sample
+// per column). A parallel counting pass per row chunk, a prefix sum over
+// (canton, chunk), then a parallel fill in which every chunk writes its own
+// disjoint slots, so the result does not depend on the thread count.
+CantonHistories buildCantonHistories(const arma::fmat &data, size_t cantonRow,
+                                     const arma::Row<size_t> &labels,
+                                     size_t numThreads = 0);
+
+#endif // CANTON_HISTORY_H
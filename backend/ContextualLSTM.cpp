@@ -0,0 +1,106 @@
+#include "ContextualLSTM.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+int64_t clampService(float label, int64_t numServices)
+{
+    return min<int64_t>(max<int64_t>((int64_t)label, 0), numServices - 1);
+}
+} // namespace
+
+CantonWindowDataset::CantonWindowDataset(const CantonHistories &histories, int64_t seqLen,
+                                         int64_t numServices, bool pinMemory)
+    : histories(&histories), seqLen(seqLen), numServices(numServices), pinMemory(pinMemory)
+{
+    windowOffsets.push_back(0);
+    for (size_t c = 0; c < histories.numCantons(); ++c)
+    {
+        size_t length = histories.length(c);
+        size_t windows = length > (size_t)seqLen ? length - (size_t)seqLen : 0;
+        windowOffsets.push_back(windowOffsets.back() + windows);
+    }
+}
+
+torch::data::Example<> CantonWindowDataset::get_batch(torch::ArrayRef<size_t> indices)
+{
+    const int64_t batch = (int64_t)indices.size();
+    const int64_t width = 1 + seqLen;
+    auto options = torch::TensorOptions().dtype(torch::kLong).pinned_memory(pinMemory);
+    torch::Tensor data = torch::empty({batch, width}, options);
+    torch::Tensor target = torch::empty({batch}, options);
+    int64_t *d = data.data_ptr<int64_t>();
+    int64_t *t = target.data_ptr<int64_t>();
+
+    for (int64_t k = 0; k < batch; ++k)
+    {
+        size_t i = indices[k];
+        size_t c = (size_t)(upper_bound(windowOffsets.begin(), windowOffsets.end(), i) -
+                            windowOffsets.begin()) - 1;
+        const float *h = histories->history(c) + (i - windowOffsets[c]);
+        int64_t *row = d + k * width;
+        row[0] = (int64_t)c;
+        for (int64_t j = 0; j < seqLen; ++j)
+            row[1 + j] = clampService(h[j], numServices);
+        t[k] = clampService(h[seqLen], numServices);
+    }
+    return {data, target};
+}
+
+double trainContextualLSTM(ContextualLSTM &model, const CantonHistories &histories,
+                           int64_t numServices, const TorchTrainOptions &opts)
+{
+    if (opts.torchThreads > 0) torch::set_num_threads((int)opts.torchThreads);
+    torch::Device device = opts.useCuda && torch::cuda::is_available() ? torch::kCUDA : torch::kCPU;
+    const bool pin = device.is_cuda(); // pinned host memory needs the CUDA allocator
+
+    CantonWindowDataset dataset(histories, opts.seqLen, numServices, pin);
+    const size_t numSamples = *dataset.size();
+    cout << "Torch LSTM: " << numSamples << " windows of " << opts.seqLen << ", batch "
+         << opts.batchSize << ", " << opts.workers << " loader thread(s), "
+         << torch::get_num_threads() << " intra-op thread(s) on " << device << endl;
+    if (numSamples == 0)
+    {
+        cerr << "No canton history is longer than the window" << endl;
+        return 0.0;
+    }
+
+    auto loader = torch::data::make_data_loader<torch::data::samplers::RandomSampler>(
+        std::move(dataset),
+        torch::data::DataLoaderOptions().batch_size(opts.batchSize).workers(opts.workers));
+
+    model->to(device);
+    model->train();
+    torch::optim::Adam optimizer(model->parameters(), torch::optim::AdamOptions(opts.learningRate));
+
+    double samplesPerSec = 0.0;
+    for (size_t epoch = 0; epoch < opts.epochs; ++epoch)
+    {
+        auto t0 = chrono::steady_clock::now();
+        double lossSum = 0.0;
+        size_t seen = 0;
+        for (torch::data::Example<> &batch : *loader)
+        {
+            torch::Tensor data = batch.data.to(device, pin);
+            torch::Tensor target = batch.target.to(device, pin);
+            torch::Tensor logits = model->forward(data.select(1, 0), data.slice(1, 1));
+            torch::Tensor loss = torch::nn::functional::cross_entropy(logits, target);
+
+            optimizer.zero_grad();
+            loss.backward();
+            optimizer.step();
+
+            lossSum += loss.item<double>() * data.size(0);
+            seen += (size_t)data.size(0);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        samplesPerSec = seconds > 0 ? seen / seconds : 0.0;
+        cout << "  Epoch " << epoch + 1 << "/" << opts.epochs << "  loss " << lossSum / max<size_t>(seen, 1)
+             << "  " << (size_t)samplesPerSec << " samples/s" << endl;
+    }
+    return samplesPerSec;
+}
@@ -0,0 +1,95 @@
+#ifndef CONTEXTUAL_LSTM_H
+#define CONTEXTUAL_LSTM_H
+
+#include "CantonHistory.h"
+#include <cstddef>
+#include <cstdint>
+#include <torch/torch.h>
+#include <vector>
+
+// ==========================================
+// LIBTORCH LSTM MODULE
+// ==========================================
+// Canton embedding + embedded service sequence -> next service logits.
+struct ContextualLSTMImpl : torch::nn::Module
+{
+    torch::nn::Embedding cantonEmb{nullptr};
+    torch::nn::Embedding serviceEmb{nullptr};
+    torch::nn::LSTM lstm{nullptr};
+    torch::nn::Linear fc{nullptr};
+    int64_t hiddenSize;
+
+    ContextualLSTMImpl(int64_t numCantones, int64_t numServicios,
+                       int64_t embCantonDim = 16, int64_t embServiceDim = 32,
+                       int64_t hidden = 64)
+        : hiddenSize(hidden)
+    {
+        cantonEmb = register_module(
+            "cantonEmb", torch::nn::Embedding(numCantones, embCantonDim));
+        serviceEmb = register_module(
+            "serviceEmb", torch::nn::Embedding(numServicios, embServiceDim));
+
+        lstm = register_module(
+            "lstm", torch::nn::LSTM(
+                torch::nn::LSTMOptions(embCantonDim + embServiceDim, hidden)
+                .batch_first(true)));
+
+        fc = register_module("fc", torch::nn::Linear(hidden, numServicios));
+    }
+
+    torch::Tensor forward(torch::Tensor cantonIds, torch::Tensor serviceSeq)
+    {
+        auto cEmb = cantonEmb(cantonIds);
+        auto sEmb = serviceEmb(serviceSeq);
+        auto cEmbRep = cEmb.unsqueeze(1).repeat({1, sEmb.size(1), 1});
+        auto x = torch::cat({cEmbRep, sEmb}, 2);
+        auto lstmOut = std::get<0>(lstm(x));
+        auto last = lstmOut.select(1, lstmOut.size(1) - 1);
+        return fc(last);
+    }
+};
+
+TORCH_MODULE(ContextualLSTM);
+
+// --- Sliding windows over the CSR canton histories ---
+// Sample i is `seqLen` consecutive services of one canton plus the service
+// that follows. Batches come out already stacked: data is int64
+// [batch, 1 + seqLen] (column 0 = dense canton id, then the sequence),
+// target is int64 [batch]. Only window counts per canton are stored; the
+// windows are read straight from the histories.
+class CantonWindowDataset
+    : public torch::data::datasets::BatchDataset<CantonWindowDataset,
+                                                 torch::data::Example<>>
+{
+private:
+    const CantonHistories *histories;
+    int64_t seqLen;
+    int64_t numServices;
+    bool pinMemory;
+    std::vector<size_t> windowOffsets; // numCantons() + 1 prefix sums
+
+public:
+    CantonWindowDataset(const CantonHistories &histories, int64_t seqLen,
+                        int64_t numServices, bool pinMemory = false);
+
+    torch::data::Example<> get_batch(torch::ArrayRef<size_t> indices) override;
+    torch::optional<size_t> size() const override { return windowOffsets.back(); }
+};
+
+struct TorchTrainOptions
+{
+    int64_t seqLen = 8;
+    size_t batchSize = 256;
+    size_t epochs = 10;
+    size_t workers = 4;      // data loader threads assembling batches
+    size_t torchThreads = 0; // intra-op threads; 0 = libtorch default
+    double learningRate = 1e-3;
+    bool useCuda = false;    // batches are pinned when training on the GPU
+};
+
+// Shuffled minibatch training with Adam and cross-entropy. Prints the mean
+// loss and samples/s of every epoch; returns the samples/s of the last one.
+double trainContextualLSTM(ContextualLSTM &model, const CantonHistories &histories,
+                           int64_t numServices, const TorchTrainOptions &opts);
+
+#endif // CONTEXTUAL_LSTM_H
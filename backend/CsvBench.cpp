@@ -0,0 +1,177 @@
+// CSV reader benchmark: the old getline + stringstream loop used by every
+// loader vs. CsvReader with each scan mode, then the old stod/stringstream
+// field helpers vs. the from_chars batch parsers in FieldParse.
+// Usage: CsvBench <file.csv> [repeats]
+#include "CsvTokenizer.h"
+#include "FieldParse.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct BenchResult {
+  size_t rows = 0;
+  size_t fields = 0;
+  double seconds = 0.0;
+};
+
+BenchResult benchGetline(const string &path) {
+  BenchResult r;
+  auto t0 = chrono::steady_clock::now();
+  ifstream file(path);
+  string line, cell;
+  while (getline(file, line)) {
+    stringstream ss(line);
+    vector<string> row;
+    while (getline(ss, cell, ','))
+      row.push_back(cell);
+    r.rows++;
+    r.fields += row.size();
+  }
+  r.seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+  return r;
+}
+
+BenchResult benchReader(const MappedFile &file, CsvScanMode mode) {
+  BenchResult r;
+  auto t0 = chrono::steady_clock::now();
+  CsvReader reader(file.data(), file.size(), mode);
+  vector<string_view> fields;
+  while (reader.next(fields)) {
+    r.rows++;
+    r.fields += fields.size();
+  }
+  r.seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+  return r;
+}
+
+// Field helpers as they were before FieldParse, kept here for comparison.
+float legacyParseNumeric(const string &s) {
+  try {
+    return stod(s);
+  } catch (...) {
+    return 0.0f;
+  }
+}
+
+float legacyParseDate(const string &dateStr) {
+  if (dateStr.empty())
+    return 0.0f;
+  string s = dateStr;
+  replace(s.begin(), s.end(), '/', ' ');
+  stringstream ss(s);
+  int d, m, y;
+  ss >> d >> m >> y;
+  return y * 10000.0f + m * 100 + d;
+}
+
+template <typename Fn> double timeIt(Fn fn) {
+  auto t0 = chrono::steady_clock::now();
+  fn();
+  return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+void reportFields(const string &name, size_t n, size_t failed, double s) {
+  cout << "  " << name << ": " << n << " cells, " << failed << " failed, "
+       << s << " s, " << n / s / 1e6 << " Mcells/s" << endl;
+}
+
+void report(const string &name, const BenchResult &r, size_t bytes) {
+  double mb = bytes / (1024.0 * 1024.0);
+  cout << "  " << name << ": " << r.rows << " rows, " << r.fields
+       << " fields, " << r.seconds << " s, " << mb / r.seconds << " MB/s"
+       << endl;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    cerr << "Usage: " << argv[0] << " <file.csv> [repeats]" << endl;
+    return 1;
+  }
+  string path = argv[1];
+  int repeats = argc > 2 ? max(1, atoi(argv[2])) : 3;
+
+  MappedFile file;
+  if (!file.open(path)) {
+    cerr << "Error: " << path << endl;
+    return 1;
+  }
+  // Touch every page once so all readers start from a warm page cache.
+  volatile char sink = 0;
+  for (size_t i = 0; i < file.size(); i += 4096)
+    sink = sink + file.data()[i];
+
+  cout << "--- CSV benchmark: " << path << " (" << file.size() / (1024 * 1024)
+       << " MB, best of " << repeats << ") ---" << endl;
+
+  auto best = [&](auto run) {
+    BenchResult b = run();
+    for (int i = 1; i < repeats; ++i) {
+      BenchResult r = run();
+      if (r.seconds < b.seconds)
+        b = r;
+    }
+    return b;
+  };
+
+  report("getline+stringstream", best([&] { return benchGetline(path); }),
+         file.size());
+  for (CsvScanMode mode :
+       {CsvScanMode::Scalar, CsvScanMode::Sse2, CsvScanMode::Avx2}) {
+    CsvReader probe(file.data(), 0, mode);
+    if (probe.scanMode() != mode)
+      continue; // not supported on this CPU
+    report(string("CsvReader ") + csvScanModeName(mode),
+           best([&] { return benchReader(file, mode); }), file.size());
+  }
+
+  // Every cell of the file, numeric or not: bad cells are part of the cost.
+  vector<string_view> cells;
+  {
+    CsvReader reader(file.data(), file.size());
+    vector<string_view> fields;
+    reader.next(fields); // header
+    while (reader.next(fields))
+      cells.insert(cells.end(), fields.begin(), fields.end());
+  }
+  // Synthetic dd/mm/yyyy dates, the format parseDate receives.
+  vector<string> dateStrings;
+  for (size_t i = 0; i < 1000000; ++i)
+    dateStrings.push_back(to_string(1 + i % 28) + "/" +
+                          to_string(1 + i % 12) + "/" +
+                          to_string(2021 + i % 5));
+  vector<string_view> dates(dateStrings.begin(), dateStrings.end());
+
+  cout << "--- Field parsing ---" << endl;
+  vector<float> floats(cells.size());
+  vector<int64_t> ints(dates.size());
+  size_t failed = 0;
+  double secs = timeIt([&] {
+    failed = 0;
+    for (size_t i = 0; i < cells.size(); ++i) {
+      floats[i] = legacyParseNumeric(string(cells[i]));
+      failed += floats[i] == 0.0f;
+    }
+  });
+  reportFields("stod+try/catch (zeros)", cells.size(), failed, secs);
+  secs = timeIt([&] {
+    failed = parseFloatColumn(cells.data(), cells.size(), floats.data());
+  });
+  reportFields("parseFloatColumn", cells.size(), failed, secs);
+  secs = timeIt([&] {
+    for (size_t i = 0; i < dates.size(); ++i)
+      ints[i] = (int64_t)legacyParseDate(dateStrings[i]);
+  });
+  reportFields("parseDate stringstream", dates.size(), 0, secs);
+  secs = timeIt([&] {
+    failed = parseDateColumn(dates.data(), dates.size(), ints.data());
+  });
+  reportFields("parseDateColumn", dates.size(), failed, secs);
+  return 0;
+}
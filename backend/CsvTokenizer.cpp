@@ -0,0 +1,287 @@
+#include "CsvTokenizer.h"
+#include "DecompressStream.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CSV_HAVE_X86 1
+#endif
+
+using namespace std;
+
+namespace {
+const size_t BLOCK = 64;
+
+// Bit i of the result is the XOR of bits 0..i of x.
+uint64_t prefixXor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+// Commas/newlines outside quotes, given the raw bitmaps of one block.
+inline uint64_t structurals(uint64_t comma, uint64_t quote, uint64_t newline,
+                            bool &inQuote) {
+  uint64_t inside = prefixXor(quote) ^ (inQuote ? ~uint64_t(0) : 0);
+  inQuote = (inside >> 63) & 1;
+  return (comma | newline) & ~inside;
+}
+
+void scanScalar(const char *p, size_t n, uint64_t *out, bool &inQuote) {
+  for (size_t b = 0; b < n; ++b, p += BLOCK) {
+    uint64_t comma = 0, quote = 0, newline = 0;
+    for (size_t i = 0; i < BLOCK; ++i) {
+      uint64_t bit = uint64_t(1) << i;
+      comma |= p[i] == ',' ? bit : 0;
+      quote |= p[i] == '"' ? bit : 0;
+      newline |= p[i] == '\n' ? bit : 0;
+    }
+    out[b] = structurals(comma, quote, newline, inQuote);
+  }
+}
+
+#ifdef CSV_HAVE_X86
+void scanSse2(const char *p, size_t n, uint64_t *out, bool &inQuote) {
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (size_t b = 0; b < n; ++b, p += BLOCK) {
+    uint64_t c = 0, q = 0, nl = 0;
+    for (int k = 0; k < 4; ++k) {
+      __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * k));
+      int shift = 16 * k;
+      c |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, comma))
+           << shift;
+      q |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote))
+           << shift;
+      nl |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline))
+            << shift;
+    }
+    out[b] = structurals(c, q, nl, inQuote);
+  }
+}
+
+__attribute__((target("avx2"))) void scanAvx2(const char *p, size_t n,
+                                              uint64_t *out, bool &inQuote) {
+  const __m256i comma = _mm256_set1_epi8(',');
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i newline = _mm256_set1_epi8('\n');
+  for (size_t b = 0; b < n; ++b, p += BLOCK) {
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i hi =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+    uint64_t c =
+        (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, comma)) |
+        ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, comma))
+         << 32);
+    uint64_t q =
+        (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, quote)) |
+        ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, quote))
+         << 32);
+    uint64_t nl =
+        (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newline)) |
+        ((uint64_t)(uint32_t)_mm256_movemask_epi8(
+             _mm256_cmpeq_epi8(hi, newline))
+         << 32);
+    out[b] = structurals(c, q, nl, inQuote);
+  }
+}
+#endif
+
+CsvScanMode resolveMode(CsvScanMode requested) {
+#ifdef CSV_HAVE_X86
+  static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+  if (requested == CsvScanMode::Auto)
+    return hasAvx2 ? CsvScanMode::Avx2 : CsvScanMode::Sse2;
+  if (requested == CsvScanMode::Avx2 && !hasAvx2)
+    return CsvScanMode::Sse2;
+  return requested;
+#else
+  (void)requested;
+  return CsvScanMode::Scalar;
+#endif
+}
+} // namespace
+
+const char *csvScanModeName(CsvScanMode mode) {
+  switch (mode) {
+  case CsvScanMode::Avx2:
+    return "AVX2";
+  case CsvScanMode::Sse2:
+    return "SSE2";
+  case CsvScanMode::Scalar:
+    return "scalar";
+  default:
+    return "auto";
+  }
+}
+
+CsvReader::CsvReader(const char *data, size_t size, CsvScanMode mode)
+    : base(data), length(size), mode(resolveMode(mode)), scan(scanScalar) {
+#ifdef CSV_HAVE_X86
+  if (this->mode == CsvScanMode::Avx2)
+    scan = scanAvx2;
+  else if (this->mode == CsvScanMode::Sse2)
+    scan = scanSse2;
+#endif
+}
+
+// Loads the next block's structural bitmap into `mask`, scanning up to
+// BATCH blocks at once. Returns false once the input is exhausted.
+bool CsvReader::nextMask() {
+  if (batchNext == batchSize) {
+    if (blockPos >= length)
+      return false;
+    size_t full = min(BATCH, (length - blockPos) / BLOCK);
+    if (full > 0) {
+      scan(base + blockPos, full, batch, inQuote);
+      batchSize = full;
+    } else {
+      // Zero padding is not structural.
+      char tail[BLOCK] = {0};
+      memcpy(tail, base + blockPos, length - blockPos);
+      scan(tail, 1, batch, inQuote);
+      batchSize = 1;
+    }
+    batchNext = 0;
+  }
+  maskBase = blockPos + batchNext * BLOCK;
+  mask = batch[batchNext++];
+  if (batchNext == batchSize)
+    blockPos += batchSize * BLOCK;
+  return true;
+}
+
+string_view CsvReader::finishField(size_t begin, size_t end) {
+  const char *f = base + begin;
+  size_t n = end - begin;
+  if (n >= 2 && f[0] == '"' && f[n - 1] == '"') {
+    string_view inner(f + 1, n - 2);
+    if (inner.find("\"\"") == string_view::npos)
+      return inner;
+    string &out = unescaped.emplace_back();
+    out.reserve(inner.size());
+    for (size_t i = 0; i < inner.size(); ++i) {
+      out.push_back(inner[i]);
+      if (inner[i] == '"' && i + 1 < inner.size() && inner[i + 1] == '"')
+        ++i;
+    }
+    return out;
+  }
+  return string_view(f, n);
+}
+
+bool CsvReader::next(vector<string_view> &fields) {
+  fields.clear();
+  unescaped.clear();
+  if (pos >= length)
+    return false;
+
+  size_t fieldStart = pos;
+  for (;;) {
+    if (mask == 0) {
+      if (!nextMask()) {
+        if (fields.empty() && fieldStart >= length) {
+          pos = length; // only blank lines were left
+          return false;
+        }
+        // Last record without a trailing newline.
+        size_t end = length;
+        if (end > fieldStart && base[end - 1] == '\r')
+          --end;
+        fields.push_back(finishField(fieldStart, end));
+        pos = length;
+        return true;
+      }
+      continue;
+    }
+
+    size_t at = maskBase + (size_t)__builtin_ctzll(mask);
+    mask &= mask - 1;
+    if (base[at] == ',') {
+      fields.push_back(finishField(fieldStart, at));
+      fieldStart = at + 1;
+      continue;
+    }
+
+    // Newline: strip '\r' and end the record.
+    size_t end = at;
+    if (end > fieldStart && base[end - 1] == '\r')
+      --end;
+    pos = at + 1;
+    if (fields.empty() && end == fieldStart) {
+      fieldStart = pos; // blank line
+      continue;
+    }
+    fields.push_back(finishField(fieldStart, end));
+    return true;
+  }
+}
+
+namespace {
+// Tokenizes a decompressed stream block by block. A record that reaches the
+// end of the buffered data may be cut in half, so unless the stream is over
+// it is left in `work` and re-read once the next block is appended.
+bool readCsvStream(DecompressStream &in, const CsvRowHandler &onRow,
+                   vector<string> *header) {
+  string work;
+  vector<string_view> fields;
+  bool first = true, more = true;
+  while (more) {
+    more = in.readBlock(work);
+    CsvReader reader(work.data(), work.size());
+    size_t start = 0;
+    for (;;) {
+      start = reader.offset();
+      if (!reader.next(fields) || (more && reader.offset() >= work.size()))
+        break;
+      if (first) {
+        if (header != nullptr)
+          header->assign(fields.begin(), fields.end());
+        first = false;
+      } else {
+        onRow(fields);
+      }
+    }
+    work.erase(0, start);
+  }
+  return !in.failed();
+}
+} // namespace
+
+bool readCsvFile(const string &path, const CsvRowHandler &onRow,
+                 vector<string> *header) {
+  if (compressionFor(path) != Compression::None) {
+    DecompressStream in;
+    if (!in.open(path))
+      return false;
+    if (!readCsvStream(in, onRow, header)) {
+      cerr << "Error: corrupt or truncated " << path << endl;
+      return false;
+    }
+    return true;
+  }
+
+  MappedFile file;
+  if (!file.open(path))
+    return false;
+  file.adviseSequential();
+
+  CsvReader reader(file.data(), file.size());
+  vector<string_view> fields;
+  if (!reader.next(fields))
+    return true; // empty file
+  if (header != nullptr)
+    header->assign(fields.begin(), fields.end());
+  while (reader.next(fields))
+    onRow(fields);
+  return true;
+}
@@ -0,0 +1,70 @@
+#ifndef CSV_TOKENIZER_H
+#define CSV_TOKENIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// How structural characters are located; Auto picks the widest available.
+enum class CsvScanMode { Auto, Scalar, Sse2, Avx2 };
+
+// --- RFC 4180 tokenizer over an in-memory buffer ---
+// Commas, quotes and newlines are found 64 bytes at a time as bitmaps
+// (simdjson-style): the quote bitmap is turned into an "inside quotes" mask
+// with a prefix XOR, and only commas/newlines outside quotes end a field.
+// Fields are string_views into the buffer; quoted fields are unwrapped, and
+// only fields containing escaped quotes ("") are copied.
+class CsvReader {
+public:
+  // Structural bitmaps for n consecutive 64-byte blocks.
+  using ScanFn = void (*)(const char *p, size_t n, uint64_t *out,
+                          bool &inQuote);
+
+private:
+  static constexpr size_t BATCH = 8; // blocks scanned per refill
+
+  const char *base;
+  size_t length;
+  size_t pos = 0;       // start of the next record
+  size_t blockPos = 0;  // offset of the next 64-byte block to scan
+  size_t maskBase = 0;  // offset of the block `mask` refers to
+  uint64_t mask = 0;    // pending structural positions in that block
+  uint64_t batch[BATCH];
+  size_t batchNext = 0, batchSize = 0;
+  bool inQuote = false; // quote state carried between blocks
+  CsvScanMode mode;
+  ScanFn scan;
+  std::deque<std::string> unescaped; // storage for fields with ""
+
+  bool nextMask();
+  std::string_view finishField(size_t begin, size_t end);
+
+public:
+  CsvReader(const char *data, size_t size,
+            CsvScanMode mode = CsvScanMode::Auto);
+
+  // Reads the next record into `fields`; returns false at end of input.
+  // Views stay valid until the next call (or as long as the buffer for
+  // fields without escaped quotes).
+  bool next(std::vector<std::string_view> &fields);
+  size_t offset() const { return pos; }
+  CsvScanMode scanMode() const { return mode; }
+};
+
+using CsvRowHandler =
+    std::function<void(const std::vector<std::string_view> &)>;
+
+// Maps `path` and calls onRow for every record after the header (whose
+// fields are copied into *header when given). .gz / .zst paths are
+// decompressed on a background thread instead (see DecompressStream).
+// Returns false if the file cannot be opened or is corrupt.
+bool readCsvFile(const std::string &path, const CsvRowHandler &onRow,
+                 std::vector<std::string> *header = nullptr);
+
+const char *csvScanModeName(CsvScanMode mode);
+
+#endif // CSV_TOKENIZER_H
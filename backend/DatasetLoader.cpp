@@ -0,0 +1,328 @@
+#include "DatasetLoader.h"
+#include "CsvTokenizer.h"
+#include "DecompressStream.h"
+#include "FieldParse.h"
+#include "Helpers.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+// Files smaller than this are parsed as one chunk.
+const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+// Parses the rows in [p, end) into `out` using `enc`.
+void parseRange(const char *p, const char *end, DatasetEncoders &enc,
+                DatasetColumns &out) {
+  CsvReader reader(p, (size_t)(end - p));
+  vector<string_view> fields;
+  while (reader.next(fields)) {
+    if (fields.size() < 5)
+      continue;
+
+    int provId = (int)enc.prov.encode(fields[0]);
+    int cantonId = (int)enc.canton.encode(provId, fields[1]);
+    float targetVal = enc.serv.encode(fields[2]);
+    int subtipoId = (int)enc.subtipo.encode(fields[3]);
+    if (targetVal < 0)
+      continue;
+
+    out.fecha.push_back(parseNumeric(fields[4]));
+    out.provincia.push_back(provId);
+    out.canton.push_back(cantonId);
+    out.subtipo.push_back(subtipoId);
+    out.servicio.push_back((uint32_t)targetVal);
+    // Stats columns in one batch; missing trailing columns stay 0.
+    size_t base = out.stats.size();
+    out.stats.resize(base + out.numStatsCols, 0.0f);
+    size_t avail = min(out.numStatsCols, fields.size() - 5);
+    parseFloatColumn(fields.data() + 5, avail, out.stats.data() + base);
+  }
+}
+
+// Splits [begin, end) into up to n pieces, each ending right after a '\n'.
+// Assumes no quoted field spans a line break, which holds for these exports.
+vector<const char *> chunkBoundaries(const char *begin, const char *end,
+                                     size_t n) {
+  vector<const char *> bounds{begin};
+  size_t target = (size_t)(end - begin) / n;
+  for (size_t i = 1; i < n; ++i) {
+    const char *from = max(bounds.back(), begin + i * target);
+    const char *nl =
+        static_cast<const char *>(memchr(from, '\n', (size_t)(end - from)));
+    if (nl == nullptr)
+      break;
+    bounds.push_back(nl + 1);
+  }
+  bounds.push_back(end);
+  return bounds;
+}
+
+// Local -> global id tables for one chunk.
+struct ChunkRemap {
+  vector<int32_t> prov, serv, subtipo;
+  unordered_map<int32_t, int32_t> canton;
+};
+
+// Feeds the chunk's dictionaries to the global encoders in local-id order
+// (= order of first appearance inside the chunk). Doing this chunk by
+// chunk, in file order, reproduces the sequential numbering.
+ChunkRemap mergeDictionaries(const DatasetEncoders &local,
+                             DatasetEncoders &global) {
+  ChunkRemap r;
+  for (const string &name : local.prov.classes())
+    r.prov.push_back((int32_t)global.prov.encode(name));
+  for (const string &name : local.serv.classes())
+    r.serv.push_back((int32_t)global.serv.encode(name));
+  for (const string &name : local.subtipo.classes())
+    r.subtipo.push_back((int32_t)global.subtipo.encode(name));
+
+  for (const auto &[localProv, cantons] : local.canton.hierarchy) {
+    int32_t globalProv = localProv < 0 ? localProv : r.prov[localProv];
+    vector<const string *> byLocalId(cantons.size());
+    for (const auto &[name, localId] : cantons)
+      byLocalId[localId] = &name;
+    for (size_t localId = 0; localId < byLocalId.size(); ++localId) {
+      int32_t localCode =
+          localProv * local.canton.OFFSET_MULTIPLIER + (int32_t)localId;
+      r.canton[localCode] =
+          (int32_t)global.canton.encode(globalProv, *byLocalId[localId]);
+    }
+  }
+  return r;
+}
+
+int32_t remapId(const vector<int32_t> &table, int32_t id) {
+  return id < 0 ? id : table[id];
+}
+} // namespace
+
+void DatasetColumns::reserve(size_t rows) {
+  fecha.reserve(rows);
+  provincia.reserve(rows);
+  canton.reserve(rows);
+  subtipo.reserve(rows);
+  servicio.reserve(rows);
+  stats.reserve(rows * numStatsCols);
+}
+
+size_t numFeatures(const DatasetColumns &cols) {
+  return FEAT_STATS + cols.numStatsCols;
+}
+
+vector<string> featureNames(size_t numFeatures) {
+  vector<string> names = {"fecha", "provincia", "canton", "subtipo"};
+  names.resize(min(names.size(), numFeatures));
+  for (size_t k = FEAT_STATS; k < numFeatures; ++k)
+    names.push_back("stat_" + to_string(k - FEAT_STATS));
+  return names;
+}
+
+namespace {
+// Compressed input: blocks arrive from the decompression thread and are
+// parsed as they come, cut after their last newline (same no-quoted-newline
+// assumption as the chunk splitter). Sequential, but overlapped with
+// inflate, which is the slower of the two.
+bool loadDatasetStream(const string &path, DatasetEncoders &enc,
+                       DatasetColumns &out, LoadStats &stats) {
+  DecompressStream in;
+  if (!in.open(path)) {
+    cerr << "Error: " << path << endl;
+    return false;
+  }
+
+  string work;
+  vector<string_view> fields;
+  bool haveHeader = false, more = true;
+  size_t blocks = 0;
+  while (more) {
+    size_t before = work.size();
+    more = in.readBlock(work);
+    stats.bytes += work.size() - before;
+    blocks += more;
+    size_t cut = more ? work.rfind('\n') + 1 : work.size(); // npos + 1 = 0
+    size_t start = 0;
+    if (!haveHeader && cut > 0) {
+      // Header: count columns dynamically
+      CsvReader headerReader(work.data(), cut);
+      headerReader.next(fields);
+      out.numStatsCols = fields.size() > 5 ? fields.size() - 5 : 0;
+      start = headerReader.offset();
+      haveHeader = true;
+    }
+    if (haveHeader)
+      parseRange(work.data() + start, work.data() + cut, enc, out);
+    work.erase(0, haveHeader ? cut : 0);
+  }
+  if (in.failed()) {
+    cerr << "Error: corrupt or truncated " << path << endl;
+    return false;
+  }
+  stats.chunks = blocks;
+  return true;
+}
+} // namespace
+
+bool loadDatasetCsv(const string &path, DatasetEncoders &enc,
+                    DatasetColumns &out, LoadStats &stats, size_t numThreads) {
+  auto t0 = chrono::steady_clock::now();
+  if (compressionFor(path) != Compression::None) {
+    stats = LoadStats();
+    if (!loadDatasetStream(path, enc, out, stats))
+      return false;
+    stats.rows = out.numRows();
+    stats.seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    return true;
+  }
+
+  MappedFile file;
+  if (!file.open(path)) {
+    cerr << "Error: " << path << endl;
+    return false;
+  }
+  file.adviseSequential();
+
+  const char *p = file.data();
+  const char *end = p + file.size();
+
+  // Header: count columns dynamically
+  vector<string_view> fields;
+  CsvReader headerReader(p, file.size());
+  headerReader.next(fields);
+  out.numStatsCols = fields.size() > 5 ? fields.size() - 5 : 0;
+  size_t headerBytes = headerReader.offset();
+  p += headerBytes;
+
+  if (numThreads == 0)
+    numThreads = defaultThreadCount();
+  size_t numChunks =
+      min(numThreads, max<size_t>(1, (size_t)(end - p) / MIN_CHUNK_BYTES));
+  vector<const char *> bounds = chunkBoundaries(p, end, numChunks);
+  numChunks = bounds.size() - 1;
+
+  // Parse every chunk with thread-local encoders.
+  vector<DatasetEncoders> localEnc(numChunks);
+  vector<DatasetColumns> localCols(numChunks);
+  size_t approxRowBytes = max<size_t>(32, headerBytes);
+  parallelFor(numChunks, numThreads, [&](size_t c) {
+    localCols[c].numStatsCols = out.numStatsCols;
+    localCols[c].reserve((size_t)(bounds[c + 1] - bounds[c]) / approxRowBytes);
+    parseRange(bounds[c], bounds[c + 1], localEnc[c], localCols[c]);
+  });
+
+  // Deterministic merge of the dictionaries (sequential, in file order).
+  vector<ChunkRemap> remaps;
+  vector<size_t> rowOffset{out.numRows()};
+  for (size_t c = 0; c < numChunks; ++c) {
+    remaps.push_back(mergeDictionaries(localEnc[c], enc));
+    rowOffset.push_back(rowOffset.back() + localCols[c].numRows());
+  }
+  localEnc.clear();
+
+  // Remap and copy the columns into place, chunks in parallel.
+  size_t total = rowOffset.back();
+  out.fecha.resize(total);
+  out.provincia.resize(total);
+  out.canton.resize(total);
+  out.subtipo.resize(total);
+  out.servicio.resize(total);
+  out.stats.resize(total * out.numStatsCols);
+  parallelFor(numChunks, numThreads, [&](size_t c) {
+    const DatasetColumns &src = localCols[c];
+    const ChunkRemap &r = remaps[c];
+    size_t base = rowOffset[c];
+    for (size_t i = 0; i < src.numRows(); ++i) {
+      out.fecha[base + i] = src.fecha[i];
+      out.provincia[base + i] = remapId(r.prov, src.provincia[i]);
+      // -1 (empty canton name) is not in the dictionary and stays as is.
+      auto canton = r.canton.find(src.canton[i]);
+      out.canton[base + i] =
+          canton == r.canton.end() ? src.canton[i] : canton->second;
+      out.subtipo[base + i] = remapId(r.subtipo, src.subtipo[i]);
+      out.servicio[base + i] = (uint32_t)r.serv[src.servicio[i]];
+    }
+    copy(src.stats.begin(), src.stats.end(),
+         out.stats.begin() + base * out.numStatsCols);
+    localCols[c] = DatasetColumns(); // free as we go
+  });
+
+  stats.bytes = file.size();
+  stats.rows = out.numRows();
+  stats.chunks = numChunks;
+  stats.seconds =
+      chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+  return true;
+}
+
+void materializeFeatures(const DatasetColumns &cols, arma::fmat &dataMat,
+                         arma::Row<size_t> &labels) {
+  const size_t n = cols.numRows();
+  const size_t nFeats = numFeatures(cols);
+  dataMat.set_size(nFeats, n);
+  labels.set_size(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    float *col = dataMat.colptr(i);
+    col[FEAT_FECHA] = cols.fecha[i]; // Date
+    col[FEAT_PROV] = (float)(max(cols.provincia[i], -1) + 1);
+    col[FEAT_CANTON] = (float)cols.canton[i];
+    col[FEAT_SUBTIPO] = (float)(max(cols.subtipo[i], -1) + 1);
+    const float *st = cols.stats.data() + i * cols.numStatsCols;
+    for (size_t k = 0; k < cols.numStatsCols; ++k)
+      col[FEAT_STATS + k] = st[k];
+    labels(i) = cols.servicio[i];
+  }
+}
+
+size_t shuffleSplitInPlace(arma::fmat &data, arma::Row<size_t> &labels,
+                           double testRatio) {
+  const size_t n = data.n_cols;
+  const size_t nTest = (size_t)(testRatio * n);
+  arma::uvec perm = arma::randperm(n);
+
+  // Apply "new column j = old column perm[j]" one cycle at a time, holding
+  // only the cycle's first column aside.
+  vector<bool> done(n, false);
+  vector<float> tmp(data.n_rows);
+  for (size_t start = 0; start < n; ++start) {
+    if (done[start])
+      continue;
+    copy(data.colptr(start), data.colptr(start) + data.n_rows, tmp.begin());
+    size_t tmpLabel = labels(start);
+    size_t j = start;
+    for (size_t k = perm(j); k != start; j = k, k = perm(j)) {
+      copy(data.colptr(k), data.colptr(k) + data.n_rows, data.colptr(j));
+      labels(j) = labels(k);
+      done[j] = true;
+    }
+    copy(tmp.begin(), tmp.end(), data.colptr(j));
+    labels(j) = tmpLabel;
+    done[j] = true;
+  }
+  return n - nTest;
+}
+
+void expandOneHotProvince(const arma::fmat &categorical, arma::fmat &oneHot) {
+  const size_t numStatsCols = categorical.n_rows - FEAT_STATS;
+  oneHot.zeros(1 + NUM_PROVINCES + 2 + numStatsCols, categorical.n_cols);
+  for (size_t i = 0; i < categorical.n_cols; ++i) {
+    const float *src = categorical.colptr(i);
+    float *dst = oneHot.colptr(i);
+    dst[0] = src[FEAT_FECHA];
+    int provId = (int)src[FEAT_PROV] - 1;
+    if (provId >= 0 && provId < NUM_PROVINCES)
+      dst[1 + provId] = 1.0f;
+    dst[1 + NUM_PROVINCES] = src[FEAT_CANTON];
+    dst[2 + NUM_PROVINCES] = src[FEAT_SUBTIPO] - 1.0f; // back to the raw id
+    for (size_t k = 0; k < numStatsCols; ++k)
+      dst[3 + NUM_PROVINCES + k] = src[FEAT_STATS + k];
+  }
+}
@@ -0,0 +1,87 @@
+#ifndef DATASET_LOADER_H
+#define DATASET_LOADER_H
+
+#include "Encoders.h"
+#include <armadillo>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --- Encoders shared by every loader / cache of the training dataset ---
+struct DatasetEncoders {
+  LabelEncoder prov, subtipo, serv;
+  HierarchicalCantonEncoder canton;
+};
+
+// --- Parsed rows, appended column by column while reading ---
+// CSV layout: provincia, canton, servicio, subtipo, fecha, stats...
+struct DatasetColumns {
+  size_t numStatsCols = 0;
+  std::vector<float> fecha;
+  std::vector<int32_t> provincia;
+  std::vector<int32_t> canton; // provId * 1000 + localId
+  std::vector<int32_t> subtipo;
+  std::vector<uint32_t> servicio; // label
+  std::vector<float> stats;       // numStatsCols per row, row after row
+
+  size_t numRows() const { return servicio.size(); }
+  void reserve(size_t rows);
+};
+
+struct LoadStats {
+  size_t bytes = 0;
+  size_t rows = 0;
+  size_t chunks = 0;
+  double seconds = 0.0;
+  double mbPerSec() const {
+    return seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+  }
+};
+
+// Feature layout: Date + Prov + Canton + Subtype + Stats
+// Province and subtype are categorical dimensions (see categoricalDims):
+// they hold id + 1, with 0 for a missing value, so every category index is
+// valid for mlpack's categorical splits.
+const size_t FEAT_FECHA = 0;
+const size_t FEAT_PROV = 1;
+const size_t FEAT_CANTON = 2;
+const size_t FEAT_SUBTIPO = 3;
+const size_t FEAT_STATS = 4;
+const size_t CATEGORICAL_FEATURES[] = {FEAT_PROV, FEAT_SUBTIPO};
+
+// Old layout, kept for --compare-onehot: Date + Prov(24 one-hot) + Canton +
+// Subtype (numeric id) + Stats.
+const int NUM_PROVINCES = 24;
+size_t numFeatures(const DatasetColumns &cols);
+// Row names in layout order (fecha, provincia, canton, subtipo, stat_0...);
+// exported forests hash them into their schema (forestSchemaHash).
+std::vector<std::string> featureNames(size_t numFeatures);
+
+// Maps the file and parses it in a single pass, split into newline-aligned
+// chunks parsed concurrently (numThreads = 0 uses every core). Each chunk
+// uses its own encoders; the merge replays the chunk dictionaries in file
+// order, so category ids are identical to a sequential run (order of first
+// appearance, exactly like the old two-pass loader). .gz / .zst inputs are
+// streamed through a decompression thread and parsed as blocks arrive;
+// stats.bytes then counts decompressed bytes.
+bool loadDatasetCsv(const std::string &path, DatasetEncoders &enc,
+                    DatasetColumns &out, LoadStats &stats,
+                    size_t numThreads = 0);
+
+// Builds the (features x rows) matrix and label row in one go.
+void materializeFeatures(const DatasetColumns &cols, arma::fmat &dataMat,
+                         arma::Row<size_t> &labels);
+
+// Train/test split without copying: shuffles the samples (columns) of
+// `data` and `labels` in place with one random permutation (arma::randperm,
+// so mlpack's seed applies) and returns the number of training columns.
+// Columns [0, nTrain) are the training set and [nTrain, n) the test set;
+// wrap them with arma's advanced constructors. Extra memory is the index
+// permutation plus one column.
+size_t shuffleSplitInPlace(arma::fmat &data, arma::Row<size_t> &labels,
+                           double testRatio);
+
+// Expands a categorical-layout matrix into the old one-hot layout.
+void expandOneHotProvince(const arma::fmat &categorical, arma::fmat &oneHot);
+
+#endif // DATASET_LOADER_H
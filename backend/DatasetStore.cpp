@@ -0,0 +1,342 @@
+#include "DatasetStore.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static_assert(sizeof(size_t) == sizeof(uint64_t),
+              "labels.u64 is mapped directly as arma::Row<size_t>");
+
+namespace {
+const char STORE_MAGIC[4] = {'T', 'H', 'D', 'S'};
+
+uint64_t fnv1a(uint64_t h, const void *data, size_t n) {
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < n; ++i) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+// --- Dictionary (de)serialization: u32 counts, u32-length strings ---
+void putU32(vector<char> &buf, uint32_t v) {
+  buf.insert(buf.end(), (const char *)&v, (const char *)&v + sizeof(v));
+}
+
+void putString(vector<char> &buf, const string &s) {
+  putU32(buf, (uint32_t)s.size());
+  buf.insert(buf.end(), s.begin(), s.end());
+}
+
+void putClasses(vector<char> &buf, const LabelEncoder &e) {
+  putU32(buf, (uint32_t)e.classes().size());
+  for (const string &name : e.classes())
+    putString(buf, name);
+}
+
+struct DictReader {
+  const char *p, *end;
+
+  bool u32(uint32_t &v) {
+    if (end - p < (ptrdiff_t)sizeof(v))
+      return false;
+    memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return true;
+  }
+  bool str(string &s) {
+    uint32_t n;
+    if (!u32(n) || end - p < (ptrdiff_t)n)
+      return false;
+    s.assign(p, n);
+    p += n;
+    return true;
+  }
+  // Replays the names in id order, which reproduces the original ids.
+  bool classes(LabelEncoder &e) {
+    uint32_t n;
+    if (!u32(n))
+      return false;
+    string name;
+    for (uint32_t i = 0; i < n; ++i)
+      if (!str(name) || e.encode(name) != (float)i)
+        return false;
+    return true;
+  }
+};
+
+bool writeFile(const fs::path &path, const void *data, size_t bytes,
+               ios::openmode mode = ios::trunc) {
+  ofstream out(path, ios::binary | mode);
+  out.write(static_cast<const char *>(data), (streamsize)bytes);
+  return (bool)out;
+}
+
+vector<char> encodeDictionaries(const DatasetEncoders &enc) {
+  vector<char> dict;
+  putClasses(dict, enc.prov);
+  putClasses(dict, enc.subtipo);
+  putClasses(dict, enc.serv);
+  putU32(dict, (uint32_t)enc.canton.hierarchy.size());
+  for (const auto &[provId, cantons] : enc.canton.hierarchy) {
+    putU32(dict, (uint32_t)provId);
+    putU32(dict, (uint32_t)cantons.size());
+    for (const auto &[name, localId] : cantons) {
+      putU32(dict, (uint32_t)localId);
+      putString(dict, name);
+    }
+  }
+  return dict;
+}
+
+bool decodeDictionaries(DictReader &r, DatasetEncoders &enc) {
+  if (!r.classes(enc.prov) || !r.classes(enc.subtipo) || !r.classes(enc.serv))
+    return false;
+  uint32_t numProvs;
+  if (!r.u32(numProvs))
+    return false;
+  for (uint32_t i = 0; i < numProvs; ++i) {
+    uint32_t provId, count;
+    if (!r.u32(provId) || !r.u32(count))
+      return false;
+    auto &cantons = enc.canton.hierarchy[(int)provId];
+    for (uint32_t j = 0; j < count; ++j) {
+      uint32_t localId;
+      string name;
+      if (!r.u32(localId) || !r.str(name))
+        return false;
+      cantons[name] = (int)localId;
+    }
+  }
+  return true;
+}
+
+// Writes meta.bin.tmp and renames it over meta.bin; this is the commit point
+// of both save and append.
+bool writeMeta(const fs::path &root, uint64_t stamp, size_t rows,
+               size_t feats, const DatasetEncoders &enc,
+               const vector<uint64_t> &appended,
+               const vector<string> &appendedPaths) {
+  vector<char> dict = encodeDictionaries(enc);
+  StoreHeader h{};
+  memcpy(h.magic, STORE_MAGIC, sizeof(h.magic));
+  h.version = STORE_LAYOUT_VERSION;
+  h.sourceStamp = stamp;
+  h.numRows = rows;
+  h.numFeatures = feats;
+  h.dictBytes = dict.size();
+  h.numAppended = appended.size();
+
+  vector<char> meta((const char *)&h, (const char *)&h + sizeof(h));
+  meta.insert(meta.end(), dict.begin(), dict.end());
+  meta.insert(meta.end(), (const char *)appended.data(),
+              (const char *)(appended.data() + appended.size()));
+  for (const string &path : appendedPaths)
+    putString(meta, path);
+  error_code ec;
+  if (!writeFile(root / "meta.bin.tmp", meta.data(), meta.size()))
+    return false;
+  fs::rename(root / "meta.bin.tmp", root / "meta.bin", ec);
+  return !ec;
+}
+struct StoreMeta {
+  StoreHeader header{};
+  vector<char> bytes;
+  const char *dict = nullptr; // header.dictBytes of encoded dictionaries
+  vector<uint64_t> appended;
+  vector<string> appendedPaths;
+};
+
+// Reads and checks meta.bin (any source stamp).
+bool readMeta(const fs::path &root, StoreMeta &m) {
+  ifstream in(root / "meta.bin", ios::binary);
+  if (!in.is_open())
+    return false;
+  m.bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+
+  StoreHeader &h = m.header;
+  if (m.bytes.size() < sizeof(h))
+    return false;
+  memcpy(&h, m.bytes.data(), sizeof(h));
+  const size_t fixedBytes =
+      sizeof(h) + h.dictBytes + h.numAppended * sizeof(uint64_t);
+  if (memcmp(h.magic, STORE_MAGIC, sizeof(h.magic)) != 0 ||
+      h.version != STORE_LAYOUT_VERSION || h.numRows == 0 ||
+      m.bytes.size() < fixedBytes)
+    return false;
+
+  m.dict = m.bytes.data() + sizeof(h);
+  m.appended.resize(h.numAppended);
+  memcpy(m.appended.data(), m.dict + h.dictBytes,
+         m.appended.size() * sizeof(uint64_t));
+  DictReader r{m.bytes.data() + fixedBytes, m.bytes.data() + m.bytes.size()};
+  m.appendedPaths.resize(h.numAppended);
+  for (string &path : m.appendedPaths)
+    if (!r.str(path))
+      return false;
+  return r.p == r.end;
+}
+} // namespace
+
+uint64_t sourceStamp(const string &path) {
+  error_code ec;
+  uint64_t size = fs::file_size(path, ec);
+  if (ec)
+    return 0;
+  auto mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+  if (ec)
+    return 0;
+  uint64_t h = 1469598103934665603ULL;
+  h = fnv1a(h, &size, sizeof(size));
+  h = fnv1a(h, &mtime, sizeof(mtime));
+  return fnv1a(h, &STORE_LAYOUT_VERSION, sizeof(STORE_LAYOUT_VERSION));
+}
+
+string storePathFor(const string &csvPath) { return csvPath + ".store"; }
+
+bool saveDatasetStore(const string &dir, uint64_t stamp,
+                      const DatasetEncoders &enc, const arma::fmat &features,
+                      const arma::Row<size_t> &labels) {
+  error_code ec;
+  fs::create_directories(dir, ec);
+  if (ec) {
+    cerr << "Error creating dataset store: " << dir << endl;
+    return false;
+  }
+  fs::path root(dir);
+
+  // Drop the old meta first: until the new one is in place the store is
+  // invalid rather than inconsistent.
+  fs::remove(root / "meta.bin", ec);
+  if (!writeFile(root / "features.f32", features.memptr(),
+                 features.n_elem * sizeof(float)) ||
+      !writeFile(root / "labels.u64", labels.memptr(),
+                 labels.n_elem * sizeof(size_t)) ||
+      !writeMeta(root, stamp, features.n_cols, features.n_rows, enc, {}, {})) {
+    cerr << "Error writing dataset store: " << dir << endl;
+    return false;
+  }
+  return true;
+}
+
+bool DatasetStore::map() {
+  fs::path dir(root);
+  if (!featFile.open((dir / "features.f32").string(), true) ||
+      !labelFile.open((dir / "labels.u64").string(), true) ||
+      featFile.size() < rows * feats * sizeof(float) ||
+      labelFile.size() < rows * sizeof(size_t)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool DatasetStore::open(const string &dir, uint64_t expectedStamp,
+                        DatasetEncoders *enc) {
+  close();
+  StoreMeta m;
+  if (!readMeta(dir, m) || m.header.sourceStamp != expectedStamp)
+    return false;
+
+  // Decode into scratch encoders so a corrupt store leaves `enc` untouched.
+  DatasetEncoders loaded;
+  DictReader r{m.dict, m.dict + m.header.dictBytes};
+  if (!decodeDictionaries(r, loaded)) {
+    cerr << "Corrupt dataset store dictionaries: " << dir << endl;
+    return false;
+  }
+
+  root = dir;
+  stamp = m.header.sourceStamp;
+  rows = m.header.numRows;
+  feats = m.header.numFeatures;
+  appended = std::move(m.appended);
+  appendedFrom = std::move(m.appendedPaths);
+  if (!map())
+    return false;
+
+  if (enc != nullptr) {
+    for (const string &name : loaded.prov.classes())
+      enc->prov.encode(name);
+    for (const string &name : loaded.subtipo.classes())
+      enc->subtipo.encode(name);
+    for (const string &name : loaded.serv.classes())
+      enc->serv.encode(name);
+    enc->canton.hierarchy = std::move(loaded.canton.hierarchy);
+  }
+  return true;
+}
+
+void DatasetStore::close() {
+  featFile.close();
+  labelFile.close();
+  appended.clear();
+  appendedFrom.clear();
+  rows = feats = 0;
+}
+
+vector<string> appendedSourcesOf(const string &dir) {
+  StoreMeta m;
+  if (readMeta(dir, m))
+    return m.appendedPaths;
+  // Older layouts record only the stamps of what was appended.
+  if (memcmp(m.header.magic, STORE_MAGIC, sizeof(m.header.magic)) == 0 &&
+      m.header.numAppended > 0)
+    cerr << "Dataset store " << dir << " has " << m.header.numAppended
+         << " appended file(s) but not their paths; rebuilding drops them"
+         << endl;
+  return {};
+}
+
+bool DatasetStore::hasSource(uint64_t sourceStamp) const {
+  return sourceStamp == stamp ||
+         find(appended.begin(), appended.end(), sourceStamp) != appended.end();
+}
+
+bool DatasetStore::append(const DatasetEncoders &enc,
+                          const arma::fmat &features,
+                          const arma::Row<size_t> &labels,
+                          uint64_t sourceStamp, const string &sourcePath) {
+  if (!isOpen() || features.n_rows != feats ||
+      labels.n_elem != features.n_cols) {
+    cerr << "Dataset store append: layout mismatch (" << features.n_rows
+         << " vs " << feats << " features)" << endl;
+    return false;
+  }
+
+  fs::path dir(root);
+  size_t oldRows = rows;
+  vector<uint64_t> sources = appended;
+  vector<string> sourcePaths = appendedFrom;
+  sources.push_back(sourceStamp);
+  sourcePaths.push_back(sourcePath);
+  featFile.close();
+  labelFile.close();
+
+  // Cut whatever an interrupted append left past numRows, then append.
+  error_code ec;
+  fs::resize_file(dir / "features.f32", oldRows * feats * sizeof(float), ec);
+  if (!ec)
+    fs::resize_file(dir / "labels.u64", oldRows * sizeof(size_t), ec);
+  bool ok = !ec &&
+            writeFile(dir / "features.f32", features.memptr(),
+                      features.n_elem * sizeof(float), ios::app) &&
+            writeFile(dir / "labels.u64", labels.memptr(),
+                      labels.n_elem * sizeof(size_t), ios::app) &&
+            writeMeta(dir, stamp, oldRows + features.n_cols, feats, enc,
+                      sources, sourcePaths);
+  if (ok) {
+    rows = oldRows + features.n_cols;
+    appended = std::move(sources);
+    appendedFrom = std::move(sourcePaths);
+  } else {
+    cerr << "Error appending to dataset store: " << root << endl;
+  }
+  // Either way meta.bin describes what is mapped now.
+  return map() && ok;
+}
@@ -0,0 +1,97 @@
+#ifndef DATASET_STORE_H
+#define DATASET_STORE_H
+
+#include "DatasetLoader.h"
+#include "MappedFile.h"
+#include <armadillo>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --- Persisted, mmap-able copy of the parsed training dataset ---
+// <csv>.store/ holds three files:
+//   meta.bin      StoreHeader + the encoder dictionaries + appended stamps
+//                 + appended paths (u32-length strings)
+//   features.f32  (numFeatures x numRows) floats, column-major = arma layout
+//   labels.u64    numRows labels (size_t)
+// The header stamps the source CSV (size + mtime); a store is only reused
+// while the stamp matches, so replacing or editing the CSV re-ingests.
+// Monthly files can be appended afterwards (DatasetStore::append); their
+// stamps are recorded so the same file is never ingested twice, and their
+// paths so a rebuild from a changed CSV can append them again.
+// meta.bin is written last (and renamed into place) and is the only record
+// of numRows, so an interrupted save or append never looks valid: bytes
+// past numRows in the data files are ignored and overwritten by the next
+// append.
+const uint32_t STORE_LAYOUT_VERSION = 4; // 4: appended source paths
+
+#pragma pack(push, 1)
+struct StoreHeader {
+  char magic[4]; // "THDS"
+  uint32_t version;
+  uint64_t sourceStamp;
+  uint64_t numRows;
+  uint64_t numFeatures;
+  uint64_t dictBytes;   // encoder dictionaries that follow the header
+  uint64_t numAppended; // stamps after the dictionaries, then as many paths
+};
+#pragma pack(pop)
+
+// Hash of the file's size and modification time; 0 if it cannot be read.
+uint64_t sourceStamp(const std::string &path);
+std::string storePathFor(const std::string &csvPath);
+// Files appended to the store in `dir`, whatever its stamp; empty if there
+// is no readable store.
+std::vector<std::string> appendedSourcesOf(const std::string &dir);
+
+bool saveDatasetStore(const std::string &dir, uint64_t stamp,
+                      const DatasetEncoders &enc, const arma::fmat &features,
+                      const arma::Row<size_t> &labels);
+
+class DatasetStore {
+private:
+  MappedFile featFile, labelFile;
+  std::string root;
+  uint64_t stamp = 0;
+  std::vector<uint64_t> appended;
+  std::vector<std::string> appendedFrom; // paths, parallel to `appended`
+  size_t rows = 0, feats = 0;
+
+  bool map();
+
+public:
+  // Maps the store if its stamp equals `expectedStamp`. When `enc` is given
+  // (it must be empty) the dictionaries are restored into it. Pages are
+  // mapped copy-on-write, so matrices built over them may be modified in
+  // place.
+  bool open(const std::string &dir, uint64_t expectedStamp,
+            DatasetEncoders *enc = nullptr);
+  void close();
+  bool isOpen() const { return featFile.isOpen(); }
+
+  // Appends rows parsed from another file. `enc` must be the encoders the
+  // store was opened with, extended by that parse (existing ids unchanged);
+  // the new dictionaries replace the stored ones. Remaps the files, so
+  // pointers from featureData()/labelData() are invalidated.
+  bool append(const DatasetEncoders &enc, const arma::fmat &features,
+              const arma::Row<size_t> &labels, uint64_t sourceStamp,
+              const std::string &sourcePath);
+  bool hasSource(uint64_t sourceStamp) const;
+
+  // For arma's advanced constructors (copy_aux_mem = false); valid while the
+  // store is open.
+  float *featureData() {
+    return reinterpret_cast<float *>(featFile.mutableData());
+  }
+  size_t *labelData() {
+    return reinterpret_cast<size_t *>(labelFile.mutableData());
+  }
+  size_t numRows() const { return rows; }
+  size_t numFeatures() const { return feats; }
+  size_t numAppended() const { return appended.size(); }
+  size_t bytes() const {
+    return rows * (feats * sizeof(float) + sizeof(size_t));
+  }
+};
+
+#endif // DATASET_STORE_H
@@ -0,0 +1,207 @@
+#include "EmbeddingStore.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+const char EMBEDDING_MAGIC[4] = {'T', 'H', 'E', 'M'};
+
+size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+
+struct EmbeddingLayout {
+  size_t zonesOfs, namesOfs, latestOfs, fechaOfs, historyOfs, total;
+};
+
+EmbeddingLayout layoutFor(uint32_t numZones, uint32_t dim, uint64_t namesBytes,
+                          uint64_t numHistory) {
+  EmbeddingLayout l;
+  l.zonesOfs = align8(sizeof(EmbeddingHeader));
+  l.namesOfs = align8(l.zonesOfs + (size_t)numZones * sizeof(EmbeddingZone));
+  l.latestOfs = align8(l.namesOfs + namesBytes);
+  l.fechaOfs = align8(l.latestOfs + (size_t)numZones * dim * sizeof(float));
+  l.historyOfs = align8(l.fechaOfs + numHistory * sizeof(int64_t));
+  l.total = align8(l.historyOfs + numHistory * dim * sizeof(float));
+  return l;
+}
+} // namespace
+
+// ==========================================
+// EmbeddingStore Implementation
+// ==========================================
+bool EmbeddingStore::bind(const char *base, size_t size) {
+  header = nullptr;
+  if (base == nullptr || size < sizeof(EmbeddingHeader))
+    return false;
+
+  const EmbeddingHeader *h = reinterpret_cast<const EmbeddingHeader *>(base);
+  if (memcmp(h->magic, EMBEDDING_MAGIC, 4) != 0 ||
+      h->version != EMBEDDING_FORMAT_VERSION || h->dim == 0)
+    return false;
+
+  EmbeddingLayout l = layoutFor(h->numZones, h->dim, h->namesBytes, h->numHistory);
+  if (size < l.total)
+    return false;
+
+  zones = reinterpret_cast<const EmbeddingZone *>(base + l.zonesOfs);
+  names = base + l.namesOfs;
+  latestRows = reinterpret_cast<const float *>(base + l.latestOfs);
+  historyFechas = reinterpret_cast<const int64_t *>(base + l.fechaOfs);
+  historyRows = reinterpret_cast<const float *>(base + l.historyOfs);
+
+  // Reject files whose offsets would walk out of the sections.
+  for (uint32_t z = 0; z < h->numZones; ++z) {
+    const EmbeddingZone &e = zones[z];
+    if ((uint64_t)e.nameOfs + e.nameLen > h->namesBytes ||
+        e.historyBegin > h->numHistory ||
+        e.historyCount > h->numHistory - e.historyBegin)
+      return false;
+  }
+
+  header = h;
+  return true;
+}
+
+bool EmbeddingStore::load(const string &path, uint32_t expectedDim) {
+  header = nullptr;
+  if (!file.open(path))
+    return false;
+  if (!bind(file.data(), file.size())) {
+    cerr << "Invalid embedding store: " << path << endl;
+    file.close();
+    return false;
+  }
+  if (header->dim != expectedDim) {
+    cerr << "Embedding dimension mismatch: " << path << " (" << header->dim
+         << " != " << expectedDim << ")" << endl;
+    header = nullptr;
+    file.close();
+    return false;
+  }
+  return true;
+}
+
+int64_t EmbeddingStore::find(const string &name) const {
+  auto nameOf = [this](uint32_t z) {
+    return string_view(names + zones[z].nameOfs, zones[z].nameLen);
+  };
+  uint32_t lo = 0, hi = numZones();
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (nameOf(mid) < name)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < numZones() && nameOf(lo) == name ? (int64_t)lo : -1;
+}
+
+// ==========================================
+// EmbeddingStoreWriter Implementation
+// ==========================================
+bool EmbeddingStoreWriter::begin(const string &outPath,
+                                 const vector<string> &zoneNames, uint32_t dim,
+                                 const vector<uint64_t> &historyCounts) {
+  path = outPath;
+  dimension = dim;
+  writeHistory = !historyCounts.empty();
+  const uint32_t n = (uint32_t)zoneNames.size();
+
+  vector<uint32_t> order(n);
+  iota(order.begin(), order.end(), 0);
+  sort(order.begin(), order.end(),
+       [&](uint32_t a, uint32_t b) { return zoneNames[a] < zoneNames[b]; });
+
+  table.assign(n, EmbeddingZone());
+  slotOf.assign(n, 0);
+  cursor.assign(n, 0);
+  string namesBlob;
+  uint64_t numHistory = 0;
+  for (uint32_t s = 0; s < n; ++s) {
+    uint32_t z = order[s];
+    slotOf[z] = s;
+    EmbeddingZone &e = table[s];
+    e.nameOfs = (uint32_t)namesBlob.size();
+    e.nameLen = (uint32_t)zoneNames[z].size();
+    e.latestFecha = -1;
+    e.historyBegin = numHistory;
+    e.historyCount = writeHistory ? historyCounts[z] : 0;
+    numHistory += e.historyCount;
+    namesBlob += zoneNames[z];
+  }
+  latestRows.assign((size_t)n * dim, 0.0f);
+
+  EmbeddingLayout l = layoutFor(n, dim, namesBlob.size(), numHistory);
+  latestOfs = l.latestOfs;
+  fechaOfs = l.fechaOfs;
+  historyOfs = l.historyOfs;
+
+  out.open(path + ".tmp", ios::in | ios::out | ios::binary | ios::trunc);
+  if (!out.is_open()) {
+    cerr << "Error creating embedding store: " << path << endl;
+    return false;
+  }
+  EmbeddingHeader h;
+  memcpy(h.magic, EMBEDDING_MAGIC, 4);
+  h.version = EMBEDDING_FORMAT_VERSION;
+  h.numZones = n;
+  h.dim = dim;
+  h.namesBytes = namesBlob.size();
+  h.numHistory = numHistory;
+  out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+  out.seekp(l.namesOfs);
+  out.write(namesBlob.data(), namesBlob.size());
+  // Size the file now; rows are written in place as they arrive.
+  out.seekp(l.total - 1);
+  out.put('\0');
+  return out.good();
+}
+
+void EmbeddingStoreWriter::add(uint32_t zone, int64_t fecha,
+                               const float *embedding) {
+  uint32_t s = slotOf[zone];
+  EmbeddingZone &e = table[s];
+  if (fecha >= e.latestFecha) {
+    e.latestFecha = fecha;
+    memcpy(latestRows.data() + (size_t)s * dimension, embedding,
+           dimension * sizeof(float));
+  }
+  if (!writeHistory || cursor[s] >= e.historyCount)
+    return;
+  uint64_t row = e.historyBegin + cursor[s]++;
+  out.seekp(fechaOfs + row * sizeof(int64_t));
+  out.write(reinterpret_cast<const char *>(&fecha), sizeof(fecha));
+  out.seekp(historyOfs + row * dimension * sizeof(float));
+  out.write(reinterpret_cast<const char *>(embedding),
+            dimension * sizeof(float));
+}
+
+bool EmbeddingStoreWriter::finish() {
+  for (size_t s = 0; s < table.size(); ++s)
+    if (cursor[s] != table[s].historyCount) {
+      cerr << "Embedding store: zone " << s << " got " << cursor[s] << " of "
+           << table[s].historyCount << " history rows" << endl;
+      out.close();
+      remove((path + ".tmp").c_str());
+      return false;
+    }
+
+  out.seekp(align8(sizeof(EmbeddingHeader)));
+  out.write(reinterpret_cast<const char *>(table.data()),
+            table.size() * sizeof(EmbeddingZone));
+  out.seekp(latestOfs);
+  out.write(reinterpret_cast<const char *>(latestRows.data()),
+            latestRows.size() * sizeof(float));
+  bool ok = out.good();
+  out.close();
+  if (!ok || rename((path + ".tmp").c_str(), path.c_str()) != 0) {
+    cerr << "Error writing embedding store: " << path << endl;
+    remove((path + ".tmp").c_str());
+    return false;
+  }
+  return true;
+}
@@ -8,25 +8,26 @@ using namespace std;
 // ==========================================
 // LabelEncoder Implementation
 // ==========================================
-float LabelEncoder::encode(string s) {
+float LabelEncoder::encode(string_view s) {
   // Trim whitespace
   const auto strBegin = s.find_first_not_of(" \t\r\n");
-  if (strBegin == string::npos)
+  if (strBegin == string_view::npos)
     return -1.0f;
   const auto strEnd = s.find_last_not_of(" \t\r\n");
   const auto strRange = strEnd - strBegin + 1;
-  string trimmed = s.substr(strBegin, strRange);
+  string_view trimmed = s.substr(strBegin, strRange);
 
-  if (forward_map.find(trimmed) != forward_map.end()) {
-    return (float)forward_map[trimmed];
+  auto it = forward_map.find(trimmed);
+  if (it != forward_map.end()) {
+    return (float)it->second;
   }
 
   if (frozen)
     return -1.0f;
 
   int new_id = reverse_map.size();
-  forward_map[trimmed] = new_id;
-  reverse_map.push_back(trimmed);
+  forward_map.emplace(string(trimmed), new_id);
+  reverse_map.emplace_back(trimmed);
 
   return (double)new_id;
 }
@@ -91,17 +92,19 @@ size_t LabelEncoder::numClasses() const { return reverse_map.size(); }
 // ==========================================
 // HierarchicalCantonEncoder Implementation
 // ==========================================
-float HierarchicalCantonEncoder::encode(int provId, string cantonName) {
+float HierarchicalCantonEncoder::encode(int provId, string_view cantonName) {
   const auto strBegin = cantonName.find_first_not_of(" \t\r\n");
-  if (strBegin == string::npos)
+  if (strBegin == string_view::npos)
     return -1.0;
   const auto strEnd = cantonName.find_last_not_of(" \t\r\n");
-  string trimmed = cantonName.substr(strBegin, strEnd - strBegin + 1);
+  string_view trimmed = cantonName.substr(strBegin, strEnd - strBegin + 1);
 
-  if (hierarchy[provId].find(trimmed) == hierarchy[provId].end()) {
-    int nextLocalId = hierarchy[provId].size();
-    hierarchy[provId][trimmed] = nextLocalId;
+  auto &cantons = hierarchy[provId];
+  auto it = cantons.find(trimmed);
+  if (it == cantons.end()) {
+    int nextLocalId = cantons.size();
+    it = cantons.emplace(string(trimmed), nextLocalId).first;
   }
 
-  return (float)((provId * OFFSET_MULTIPLIER) + hierarchy[provId][trimmed]);
+  return (float)((provId * OFFSET_MULTIPLIER) + it->second);
 }
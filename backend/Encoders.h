@@ -1,35 +1,48 @@
 #ifndef ENCODERS_H
 #define ENCODERS_H
 
+#include <functional>
 #include <map>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+// Transparent hash so lookups by string_view do not build a std::string.
+struct StringViewHash {
+  using is_transparent = void;
+  size_t operator()(std::string_view s) const {
+    return std::hash<std::string_view>{}(s);
+  }
+};
+
 // --- Robust Label Encoder ---
 class LabelEncoder {
 private:
-  std::unordered_map<std::string, int> forward_map;
+  std::unordered_map<std::string, int, StringViewHash, std::equal_to<>>
+      forward_map;
   std::vector<std::string> reverse_map;
   bool frozen = false;
 
 public:
-  float encode(std::string s);
+  float encode(std::string_view s);
   std::string decode(int id) const;
   void freeze();
   void unfreeze();
   void save(const std::string &filename);
   void load(const std::string &filename);
   size_t numClasses() const;
+  // Class names in id order.
+  const std::vector<std::string> &classes() const { return reverse_map; }
 };
 
 // --- Hierarchical Encoder (Province -> Canton) ---
 class HierarchicalCantonEncoder {
 public:
-  std::map<int, std::map<std::string, int>> hierarchy;
+  std::map<int, std::map<std::string, int, std::less<>>> hierarchy;
   const int OFFSET_MULTIPLIER = 1000;
 
-  float encode(int provId, std::string cantonName);
+  float encode(int provId, std::string_view cantonName);
 };
 
 #endif // ENCODERS_H
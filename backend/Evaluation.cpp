@@ -0,0 +1,121 @@
+#include "Evaluation.h"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+string jsonString(const string &s) {
+  string out = "\"";
+  for (unsigned char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += (char)c;
+    } else if (c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += (char)c;
+    }
+  }
+  return out + "\"";
+}
+
+string className(const vector<string> &names, size_t k) {
+  return k < names.size() ? names[k] : to_string(k);
+}
+} // namespace
+
+void finalizeReport(EvalReport &r) {
+  const size_t C = r.numClasses;
+  r.precision.assign(C, 0.0);
+  r.recall.assign(C, 0.0);
+  r.support.assign(C, 0);
+  vector<uint64_t> predicted(C, 0);
+  uint64_t correct = 0, total = 0;
+  for (size_t a = 0; a < C; ++a) {
+    for (size_t p = 0; p < C; ++p) {
+      uint64_t n = r.confusion[a * C + p];
+      r.support[a] += n;
+      predicted[p] += n;
+      total += n;
+    }
+    correct += r.confusion[a * C + a];
+  }
+  for (size_t k = 0; k < C; ++k) {
+    uint64_t tp = r.confusion[k * C + k];
+    r.precision[k] = predicted[k] > 0 ? (double)tp / predicted[k] : 0.0;
+    r.recall[k] = r.support[k] > 0 ? (double)tp / r.support[k] : 0.0;
+  }
+  r.accuracy = total > 0 ? (double)correct / total : 0.0;
+}
+
+void printEvalReport(const EvalReport &r, const vector<string> &classNames) {
+  cout << "Accuracy: " << r.accuracy << " over " << r.rows << " " << r.source
+       << " rows" << endl;
+  cout << "Throughput: " << (size_t)r.rowsPerSec << " rows/s (" << r.seconds
+       << " s, " << r.threads << " thread(s))" << endl;
+  cout << setw(24) << left << "  Class" << right << setw(11) << "Precision"
+       << setw(9) << "Recall" << setw(10) << "Support" << endl;
+  for (size_t k = 0; k < r.numClasses; ++k) {
+    cout << "  " << setw(22) << left << className(classNames, k) << right
+         << setw(11) << fixed << setprecision(4) << r.precision[k] << setw(9)
+         << r.recall[k] << setw(10) << r.support[k] << endl;
+  }
+  cout.unsetf(ios::fixed);
+  cout << setprecision(6);
+}
+
+bool writeEvalReportJson(const string &path, const string &modelPath,
+                         const EvalReport &r, const vector<string> &classNames) {
+  ofstream out(path);
+  if (!out) {
+    cerr << "Error writing evaluation report: " << path << endl;
+    return false;
+  }
+  char created[32];
+  time_t now = time(nullptr);
+  strftime(created, sizeof(created), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+  const size_t C = r.numClasses;
+  out << setprecision(6);
+  out << "{\n";
+  out << "  \"model\": " << jsonString(modelPath) << ",\n";
+  out << "  \"created\": \"" << created << "\",\n";
+  out << "  \"source\": " << jsonString(r.source) << ",\n";
+  out << "  \"rows\": " << r.rows << ",\n";
+  out << "  \"accuracy\": " << r.accuracy << ",\n";
+  out << "  \"seconds\": " << r.seconds << ",\n";
+  out << "  \"rows_per_sec\": " << r.rowsPerSec << ",\n";
+  out << "  \"threads\": " << r.threads << ",\n";
+  out << "  \"classes\": [\n";
+  for (size_t k = 0; k < C; ++k) {
+    out << "    {\"name\": " << jsonString(className(classNames, k))
+        << ", \"precision\": " << r.precision[k]
+        << ", \"recall\": " << r.recall[k] << ", \"support\": " << r.support[k]
+        << "}" << (k + 1 < C ? "," : "") << "\n";
+  }
+  out << "  ],\n";
+  out << "  \"confusion\": [\n";
+  for (size_t a = 0; a < C; ++a) {
+    out << "    [";
+    for (size_t p = 0; p < C; ++p)
+      out << (p > 0 ? ", " : "") << r.confusion[a * C + p];
+    out << "]" << (a + 1 < C ? "," : "") << "\n";
+  }
+  out << "  ]\n";
+  out << "}\n";
+  return (bool)out;
+}
+
+string evalReportPathFor(const string &modelPath) {
+  size_t slash = modelPath.find_last_of('/');
+  size_t dot = modelPath.find_last_of('.');
+  if (dot == string::npos || (slash != string::npos && dot < slash))
+    return modelPath + ".eval.json";
+  return modelPath.substr(0, dot) + ".eval.json";
+}
@@ -0,0 +1,97 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include "Parallel.h"
+#include <armadillo>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// --- Batch evaluation of a trained classifier ---
+struct EvalReport {
+  std::string source = "holdout"; // rows scored: "holdout" or "out-of-bag"
+  size_t numClasses = 0;
+  size_t rows = 0;
+  double accuracy = 0.0;
+  // numClasses x numClasses, row-major: [actual * numClasses + predicted]
+  std::vector<uint64_t> confusion;
+  std::vector<double> precision; // per class; 0 when nothing was predicted
+  std::vector<double> recall;    // per class; 0 when the class is absent
+  std::vector<uint64_t> support; // actual rows per class
+  double seconds = 0.0;          // prediction wall time
+  double rowsPerSec = 0.0;
+  size_t threads = 0;
+};
+
+// Derives accuracy, precision, recall and support from r.confusion.
+void finalizeReport(EvalReport &r);
+
+// Scores the columns of `data` in chunks of `chunkRows`, spread over
+// numThreads threads (0 = every core). Each chunk aliases its columns and
+// goes through model.Classify; workers pin OpenMP to one thread so the
+// chunks do not oversubscribe the cores. Every chunk fills its own
+// confusion matrix, merged at the end.
+template <typename Model>
+EvalReport evaluateClassifier(const Model &model, const arma::fmat &data,
+                              const arma::Row<size_t> &labels,
+                              size_t numClasses, size_t numThreads = 0,
+                              size_t chunkRows = 16384) {
+  EvalReport r;
+  r.numClasses = numClasses;
+  r.rows = data.n_cols;
+  r.threads = numThreads == 0 ? defaultThreadCount() : numThreads;
+  r.confusion.assign(numClasses * numClasses, 0);
+
+  const size_t numChunks = (data.n_cols + chunkRows - 1) / chunkRows;
+  std::vector<std::vector<uint64_t>> partial(numChunks);
+  auto t0 = std::chrono::steady_clock::now();
+  parallelFor(numChunks, r.threads, [&](size_t c) {
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+    const size_t begin = c * chunkRows;
+    const size_t cols = std::min(chunkRows, (size_t)data.n_cols - begin);
+    const arma::fmat chunk(const_cast<float *>(data.colptr(begin)), data.n_rows,
+                           cols, false, true);
+    arma::Row<size_t> predictions;
+    model.Classify(chunk, predictions);
+
+    std::vector<uint64_t> &counts = partial[c];
+    counts.assign(numClasses * numClasses, 0);
+    for (size_t i = 0; i < cols; ++i) {
+      size_t actual = labels(begin + i), predicted = predictions(i);
+      if (actual < numClasses && predicted < numClasses)
+        counts[actual * numClasses + predicted]++;
+    }
+  });
+  r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+                  .count();
+  r.rowsPerSec = r.seconds > 0 ? r.rows / r.seconds : 0.0;
+
+  for (const std::vector<uint64_t> &counts : partial)
+    for (size_t k = 0; k < counts.size(); ++k)
+      r.confusion[k] += counts[k];
+  finalizeReport(r);
+  return r;
+}
+
+// Console summary: accuracy, throughput and the per-class table.
+void printEvalReport(const EvalReport &r,
+                     const std::vector<std::string> &classNames);
+
+// Writes the report as JSON (model path, build time, metrics, confusion
+// matrix). Returns false when the file cannot be written.
+bool writeEvalReportJson(const std::string &path, const std::string &modelPath,
+                         const EvalReport &r,
+                         const std::vector<std::string> &classNames);
+
+// "dir/rf_model.bin" -> "dir/rf_model.eval.json"
+std::string evalReportPathFor(const std::string &modelPath);
+
+#endif // EVALUATION_H
@@ -0,0 +1,37 @@
+#ifndef FIELD_PARSE_H
+#define FIELD_PARSE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Why a field could not be parsed. Parsers never throw and never allocate.
+enum class ParseError { None, Empty, Invalid, OutOfRange };
+
+const char *parseErrorName(ParseError e);
+
+// --- Scalar parsers (std::from_chars over string_view) ---
+// Leading/trailing blanks and a leading '+' are accepted; anything else left
+// over is Invalid. `out` is only written on success.
+
+// Decimal or scientific notation ("3.5", "-1e3", "20251001.0").
+ParseError parseFloat(std::string_view s, float &out);
+
+// Integer, also in the "20251001.0" style the exports use for dates and ids:
+// a fractional part made only of digits is truncated, like stol did.
+ParseError parseInt(std::string_view s, int64_t &out);
+
+// "dd/mm/yyyy" (also d/m/yyyy) -> yyyymmdd. Day and month are range-checked.
+ParseError parseDateDmy(std::string_view s, int64_t &yyyymmdd);
+
+// --- Batch API: one column at a time ---
+// Parses cells[0..n) into out[0..n); cells that fail get `fallback`.
+// Returns the number of cells that failed (Empty included).
+size_t parseFloatColumn(const std::string_view *cells, size_t n, float *out,
+                        float fallback = 0.0f);
+size_t parseIntColumn(const std::string_view *cells, size_t n, int64_t *out,
+                      int64_t fallback = 0);
+size_t parseDateColumn(const std::string_view *cells, size_t n, int64_t *out,
+                       int64_t fallback = 0);
+
+#endif // FIELD_PARSE_H
@@ -0,0 +1,99 @@
+#ifndef FOREST_FORMAT_H
+#define FOREST_FORMAT_H
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ==========================================
+// Binary Random Forest format (.bin)
+// ==========================================
+// File layout (every section starts on an 8-byte boundary):
+//   ForestHeader
+//   int32  roots[numTrees]        -> index of each tree's root node
+//   ForestNode nodes[numNodes]    -> all trees, flattened
+//   float  classValues[numClasses]
+// The server maps the file and reads the arrays in place (no parsing).
+
+const uint32_t FOREST_FORMAT_VERSION = 1;
+
+struct ForestHeader {
+  char magic[4]; // "THRF"
+  uint32_t version;
+  uint32_t numTrees;
+  uint32_t numNodes;
+  uint32_t numFeatures;
+  uint32_t numClasses;
+  uint64_t schemaHash; // FNV-1a of the feature names (see forestSchemaHash)
+};
+
+struct ForestNode {
+  int32_t feature;  // -1 for leaves
+  float threshold;  // go left when x[feature] <= threshold
+  int32_t left;     // children always come after their parent
+  int32_t right;
+  int32_t classIdx; // leaves only: index into classValues
+};
+
+// FNV-1a over "name1,name2,..."; both trainer and server must agree on order.
+uint64_t forestSchemaHash(const std::vector<std::string> &featureNames);
+
+// Reads only the header, e.g. to pick the expected schema before load().
+// Checks the magic and version; the rest is validated by load().
+bool readForestHeader(const std::string &path, ForestHeader &header);
+
+// --- Flattened forest, either mmapped from disk or built in memory ---
+class FlatForest {
+private:
+  MappedFile file;
+  std::vector<char> owned; // used when the forest was built in memory
+  const ForestHeader *header = nullptr;
+  const int32_t *roots = nullptr;
+  const ForestNode *nodes = nullptr;
+  const float *classValues = nullptr;
+
+  bool bind(const char *base, size_t size);
+  int leafClass(const float *features, uint32_t tree) const;
+
+public:
+  // Maps the file; fails (and leaves the forest empty) if the magic,
+  // version, sizes or schema hash do not match.
+  bool load(const std::string &path, uint64_t expectedSchemaHash);
+  bool save(const std::string &path) const;
+  // Takes ownership of a serialized image produced by ForestBuilder.
+  bool adopt(std::vector<char> image);
+
+  // Majority vote; returns the class value (same as RTrees::predict).
+  float predict(const float *features) const;
+  // Fraction of trees voting for classValue (0..1).
+  float voteShare(const float *features, float classValue) const;
+
+  bool empty() const { return header == nullptr; }
+  uint32_t numTrees() const { return header ? header->numTrees : 0; }
+  uint32_t numNodes() const { return header ? header->numNodes : 0; }
+  uint32_t numFeatures() const { return header ? header->numFeatures : 0; }
+  uint64_t schemaHash() const { return header ? header->schemaHash : 0; }
+};
+
+// --- Incremental writer used by the trainers / XML importer ---
+class ForestBuilder {
+private:
+  std::vector<int32_t> roots;
+  std::vector<ForestNode> nodes;
+  std::vector<float> classValues;
+
+public:
+  // Returns the index of the class value, adding it if it is new.
+  int32_t classIndex(float value);
+  // Starts a new tree; the next addNode() is its root.
+  void beginTree();
+  // Returns the global index of the node; children are patched later.
+  int32_t addNode(const ForestNode &node);
+  ForestNode &node(int32_t idx) { return nodes[idx]; }
+  size_t numTrees() const { return roots.size(); }
+
+  std::vector<char> serialize(uint32_t numFeatures, uint64_t schemaHash) const;
+};
+
+#endif // FOREST_FORMAT_H
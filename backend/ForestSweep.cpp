@@ -0,0 +1,113 @@
+#include "ForestSweep.h"
+#include "Parallel.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+using namespace mlpack;
+
+namespace {
+using SweepForest = RandomForest<GiniGain, MultipleRandomDimensionSelect>;
+
+size_t modelBytes(const SweepForest &rf) {
+  ostringstream os;
+  {
+    cereal::BinaryOutputArchive ar(os);
+    ar(cereal::make_nvp("rf", rf));
+  }
+  return os.str().size();
+}
+
+SweepResult trainOne(const SweepConfig &cfg, const arma::fmat &trainData,
+                     const data::DatasetInfo &info,
+                     const arma::Row<size_t> &trainLabels,
+                     const arma::fmat &testData,
+                     const arma::Row<size_t> &testLabels, size_t numClasses) {
+  SweepResult r;
+  r.config = cfg;
+  size_t dims = max<size_t>(
+      1, (size_t)lround(cfg.dimFraction * (double)trainData.n_rows));
+
+  SweepForest rf;
+  auto t0 = chrono::steady_clock::now();
+  rf.Train(trainData, info, trainLabels, numClasses, cfg.numTrees,
+           cfg.minLeaf, 1e-7, 0, false, MultipleRandomDimensionSelect(dims));
+  r.trainSeconds =
+      chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+  arma::Row<size_t> predictions;
+  rf.Classify(testData, predictions);
+  r.accuracy = (double)arma::accu(predictions == testLabels) / testLabels.n_elem;
+  r.modelBytes = modelBytes(rf);
+  return r;
+}
+} // namespace
+
+vector<SweepConfig> sweepGrid() {
+  vector<SweepConfig> configs;
+  for (size_t trees : {10, 20, 50})
+    for (size_t leaf : {10, 50, 100})
+      for (double frac : {0.3, 0.6, 1.0})
+        configs.push_back({trees, leaf, frac});
+  return configs;
+}
+
+vector<SweepConfig> sweepRandom(size_t count) {
+  vector<SweepConfig> configs;
+  for (size_t i = 0; i < count; ++i) {
+    // Leaf size is drawn log-uniformly: 1..256 matters more at the low end.
+    size_t trees = (size_t)RandInt(5, 101);
+    size_t leaf = (size_t)lround(exp2(Random(0.0, 8.0)));
+    double frac = Random(0.1, 1.0);
+    configs.push_back({trees, leaf, frac});
+  }
+  return configs;
+}
+
+vector<SweepResult> runSweep(const vector<SweepConfig> &configs,
+                             const arma::fmat &trainData,
+                             const data::DatasetInfo &info,
+                             const arma::Row<size_t> &trainLabels,
+                             const arma::fmat &testData,
+                             const arma::Row<size_t> &testLabels,
+                             size_t numClasses, size_t threadBudget) {
+  if (threadBudget == 0)
+    threadBudget = defaultThreadCount();
+  size_t concurrent = max<size_t>(1, min(configs.size(), threadBudget));
+  size_t threadsPerConfig = max<size_t>(1, threadBudget / concurrent);
+  cout << "Sweep: " << configs.size() << " configurations, " << concurrent
+       << " at a time, " << threadsPerConfig << " thread(s) each" << endl;
+
+  vector<SweepResult> results(configs.size());
+  parallelFor(configs.size(), concurrent, [&](size_t i) {
+#ifdef _OPENMP
+    omp_set_num_threads((int)threadsPerConfig);
+#endif
+    results[i] = trainOne(configs[i], trainData, info, trainLabels, testData,
+                          testLabels, numClasses);
+    cout << "  [" << i + 1 << "/" << configs.size() << "] done\n" << flush;
+  });
+  return results;
+}
+
+void printSweepTable(const vector<SweepResult> &results) {
+  cout << "\n" << setw(6) << "Trees" << setw(9) << "MinLeaf" << setw(8)
+       << "DimFrac" << setw(10) << "Accuracy" << setw(10) << "Train s"
+       << setw(11) << "Model KB" << endl;
+  for (const SweepResult &r : results) {
+    cout << setw(6) << r.config.numTrees << setw(9) << r.config.minLeaf
+         << setw(8) << fixed << setprecision(2) << r.config.dimFraction
+         << setw(10) << setprecision(4) << r.accuracy << setw(10)
+         << setprecision(2) << r.trainSeconds << setw(11) << setprecision(1)
+         << r.modelBytes / 1024.0 << endl;
+  }
+  cout.unsetf(ios::fixed);
+  cout << setprecision(6);
+}
@@ -0,0 +1,41 @@
+#ifndef FOREST_SWEEP_H
+#define FOREST_SWEEP_H
+
+#include <armadillo>
+#include <cstddef>
+#include <mlpack.hpp>
+#include <vector>
+
+// --- In-memory Random Forest hyperparameter sweep ---
+// The dataset is loaded and split once; every configuration trains on the
+// same matrices. Configurations run concurrently, splitting a thread budget
+// between them (each gets budget / concurrent OpenMP threads for mlpack's
+// per-tree loop).
+struct SweepConfig {
+  size_t numTrees;
+  size_t minLeaf;
+  double dimFraction; // share of dimensions tried at each split
+};
+
+struct SweepResult {
+  SweepConfig config;
+  double accuracy = 0.0;
+  double trainSeconds = 0.0;
+  size_t modelBytes = 0; // serialized (binary) size
+};
+
+// 3 x 3 x 3 grid around the production setting (20 trees, minLeaf 50).
+std::vector<SweepConfig> sweepGrid();
+// `count` configurations drawn with mlpack's RNG (so its seed applies).
+std::vector<SweepConfig> sweepRandom(size_t count);
+
+std::vector<SweepResult>
+runSweep(const std::vector<SweepConfig> &configs, const arma::fmat &trainData,
+         const mlpack::data::DatasetInfo &info,
+         const arma::Row<size_t> &trainLabels, const arma::fmat &testData,
+         const arma::Row<size_t> &testLabels, size_t numClasses,
+         size_t threadBudget = 0);
+
+void printSweepTable(const std::vector<SweepResult> &results);
+
+#endif // FOREST_SWEEP_H
@@ -1,32 +1,20 @@
 #include "Helpers.h"
-#include <algorithm>
+#include "FieldParse.h"
 #include <cmath>
 #include <iostream>
-#include <sstream>
 
 using namespace std;
 
-float parseDate(const string &dateStr) {
-  if (dateStr.empty())
-    return 0.0f;
-  string s = dateStr;
-  replace(s.begin(), s.end(), '/', ' ');
-  stringstream ss(s);
-  int d, m, y;
-  ss >> d >> m >> y;
-  return y * 10000.0f + m * 100 + d;
+float parseDate(string_view dateStr) {
+  int64_t yyyymmdd = 0;
+  parseDateDmy(dateStr, yyyymmdd);
+  return (float)yyyymmdd;
 }
 
-float parseNumeric(const string &s) {
-  if (s.empty())
-    return 0.0f;
-  if (all_of(s.begin(), s.end(), [](unsigned char c) { return isspace(c); }))
-    return 0.0f;
-  try {
-    return stod(s);
-  } catch (...) {
-    return 0.0f;
-  }
+float parseNumeric(string_view s) {
+  float v = 0.0f;
+  parseFloat(s, v);
+  return v;
 }
 
 void CheckOrthogonality(const arma::fmat &features,
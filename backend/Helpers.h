@@ -3,10 +3,12 @@
 
 #include <armadillo>
 #include <string>
+#include <string_view>
 #include <vector>
 
-float parseDate(const std::string &dateStr);
-float parseNumeric(const std::string &s);
+// Lenient wrappers over FieldParse: malformed or empty fields give 0.
+float parseDate(std::string_view dateStr); // dd/mm/yyyy -> yyyymmdd
+float parseNumeric(std::string_view s);
 void CheckOrthogonality(const arma::fmat &features,
                         const std::vector<std::string> &featureNames);
 
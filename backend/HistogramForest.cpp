@@ -0,0 +1,344 @@
+#include "HistogramForest.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+namespace {
+// Nodes at least this large split their feature histograms across threads.
+const size_t PARALLEL_NODE_ROWS = 1 << 15;
+
+uint8_t binOf(const vector<float> &upper, float x) {
+  size_t b = (size_t)(lower_bound(upper.begin(), upper.end(), x) - upper.begin());
+  return (uint8_t)min(b, upper.size() - 1);
+}
+
+struct TreeNode {
+  int32_t feature = -1;
+  float threshold = 0.0f;
+  int32_t left = -1, right = -1;
+  int32_t label = 0;
+  uint8_t bin = 0; // go left when the row's bin <= bin (same as threshold)
+};
+
+struct GrownTree {
+  vector<TreeNode> nodes;
+  vector<uint64_t> inBag; // bit r: row r was drawn at least once
+};
+
+struct SplitCandidate {
+  double impurity = INFINITY; // N * weighted Gini of the two children
+  int32_t feature = -1;
+  int32_t bin = -1;
+};
+
+class TreeGrower {
+private:
+  const BinnedDataset &X;
+  const size_t *y;
+  const size_t numClasses;
+  const HistForestOptions &opts;
+  const size_t mtry;
+  const size_t nodeThreads;
+  mt19937_64 rng;
+  vector<uint32_t> rows; // bootstrap sample, partitioned node by node
+  vector<uint32_t> featureOrder;
+
+  // Best split of rows[begin, end) on feature f using a fresh histogram.
+  SplitCandidate scanFeature(size_t f, size_t begin, size_t end,
+                             const vector<uint32_t> &total,
+                             vector<uint32_t> &hist) const {
+    SplitCandidate best;
+    const size_t nb = X.upper[f].size();
+    if (nb < 2)
+      return best;
+    const size_t C = numClasses;
+    hist.assign(nb * C, 0);
+    const uint8_t *col = X.column(f);
+    for (size_t i = begin; i < end; ++i) {
+      uint32_t r = rows[i];
+      hist[col[r] * C + y[r]]++;
+    }
+
+    // Running class counts left of the cut; sum of squares kept up to date
+    // so each bin costs O(classes).
+    vector<uint32_t> left(C, 0);
+    const double n = (double)(end - begin);
+    double nL = 0, sqL = 0, sqR = 0;
+    for (size_t c = 0; c < C; ++c)
+      sqR += (double)total[c] * total[c];
+    for (size_t b = 0; b + 1 < nb; ++b) {
+      const uint32_t *h = hist.data() + b * C;
+      for (size_t c = 0; c < C; ++c) {
+        if (h[c] == 0)
+          continue;
+        double l = left[c], r = total[c] - l;
+        sqL += (l + h[c]) * (l + h[c]) - l * l;
+        sqR += (r - h[c]) * (r - h[c]) - r * r;
+        left[c] += h[c];
+        nL += h[c];
+      }
+      double nR = n - nL;
+      if (nL < opts.minLeaf || nR < opts.minLeaf)
+        continue;
+      double impurity = (nL - sqL / nL) + (nR - sqR / nR);
+      if (impurity < best.impurity) {
+        best.impurity = impurity;
+        best.feature = (int32_t)f;
+        best.bin = (int32_t)b;
+      }
+    }
+    return best;
+  }
+
+public:
+  vector<TreeNode> nodes;
+  vector<uint64_t> inBag;
+
+  TreeGrower(const BinnedDataset &X, const size_t *y, size_t numClasses,
+             const HistForestOptions &opts, size_t mtry, size_t nodeThreads,
+             uint64_t seed)
+      : X(X), y(y), numClasses(numClasses), opts(opts), mtry(mtry),
+        nodeThreads(nodeThreads), rng(seed), featureOrder(X.numFeatures) {
+    for (size_t f = 0; f < X.numFeatures; ++f)
+      featureOrder[f] = (uint32_t)f;
+  }
+
+  void grow() {
+    const size_t n = X.numRows;
+    uniform_int_distribution<uint32_t> pick(0, (uint32_t)n - 1);
+    rows.resize(n);
+    inBag.assign((n + 63) / 64, 0);
+    for (size_t i = 0; i < n; ++i) {
+      rows[i] = pick(rng);
+      inBag[rows[i] >> 6] |= uint64_t(1) << (rows[i] & 63);
+    }
+
+    struct Task {
+      size_t begin, end, depth;
+      int32_t node;
+    };
+    vector<Task> stack{{0, n, 0, 0}};
+    nodes.assign(1, TreeNode());
+    vector<uint32_t> total(numClasses), hist;
+    vector<SplitCandidate> found(mtry);
+
+    while (!stack.empty()) {
+      Task t = stack.back();
+      stack.pop_back();
+      const size_t size = t.end - t.begin;
+
+      fill(total.begin(), total.end(), 0);
+      for (size_t i = t.begin; i < t.end; ++i)
+        total[y[rows[i]]]++;
+      size_t major = (size_t)(max_element(total.begin(), total.end()) -
+                              total.begin());
+      nodes[t.node].label = (int32_t)major;
+      if (total[major] == size || size < 2 * opts.minLeaf ||
+          (opts.maxDepth > 0 && t.depth >= opts.maxDepth))
+        continue;
+
+      // mtry distinct candidate features (partial Fisher-Yates).
+      for (size_t k = 0; k < mtry; ++k) {
+        uniform_int_distribution<size_t> d(k, X.numFeatures - 1);
+        swap(featureOrder[k], featureOrder[d(rng)]);
+      }
+      if (nodeThreads > 1 && size >= PARALLEL_NODE_ROWS) {
+        parallelFor(mtry, nodeThreads, [&](size_t k) {
+          vector<uint32_t> localHist;
+          found[k] = scanFeature(featureOrder[k], t.begin, t.end, total,
+                                 localHist);
+        });
+      } else {
+        for (size_t k = 0; k < mtry; ++k)
+          found[k] = scanFeature(featureOrder[k], t.begin, t.end, total, hist);
+      }
+      SplitCandidate best;
+      for (const SplitCandidate &c : found)
+        if (c.impurity < best.impurity)
+          best = c;
+
+      double parent = 0;
+      for (uint32_t c : total)
+        parent += (double)c * c;
+      parent = size - parent / size;
+      if (best.feature < 0 || parent - best.impurity <= 1e-7)
+        continue;
+
+      const uint8_t *col = X.column(best.feature);
+      uint8_t cut = (uint8_t)best.bin;
+      size_t mid = (size_t)(partition(rows.begin() + t.begin,
+                                      rows.begin() + t.end,
+                                      [&](uint32_t r) { return col[r] <= cut; }) -
+                            rows.begin());
+
+      int32_t left = (int32_t)nodes.size();
+      nodes.resize(nodes.size() + 2);
+      TreeNode &node = nodes[t.node];
+      node.feature = best.feature;
+      node.threshold = X.upper[best.feature][best.bin];
+      node.bin = cut;
+      node.left = left;
+      node.right = left + 1;
+      stack.push_back({mid, t.end, t.depth + 1, left + 1});
+      stack.push_back({t.begin, mid, t.depth + 1, left});
+    }
+    rows = vector<uint32_t>(); // free the bootstrap
+  }
+};
+
+// Majority vote, per row, of the trees whose bootstrap missed it. Walks the
+// binned columns, so no float matrix is touched.
+void scoreOutOfBag(const BinnedDataset &X, const size_t *y, size_t numClasses,
+                   const vector<GrownTree> &trees, size_t numThreads,
+                   HistTrainStats &stats) {
+  const size_t n = X.numRows;
+  const size_t chunk = 1 << 14;
+  const size_t numChunks = (n + chunk - 1) / chunk;
+  vector<vector<uint64_t>> partial(numChunks);
+  parallelFor(numChunks, numThreads, [&](size_t c) {
+    vector<uint64_t> &counts = partial[c];
+    counts.assign(numClasses * numClasses, 0);
+    vector<uint32_t> votes(numClasses);
+    for (size_t r = c * chunk; r < min(n, (c + 1) * chunk); ++r) {
+      fill(votes.begin(), votes.end(), 0);
+      bool voted = false;
+      for (const GrownTree &t : trees) {
+        if ((t.inBag[r >> 6] >> (r & 63)) & 1)
+          continue;
+        int32_t i = 0;
+        while (t.nodes[i].feature >= 0) {
+          const TreeNode &node = t.nodes[i];
+          i = X.column(node.feature)[r] <= node.bin ? node.left : node.right;
+        }
+        votes[t.nodes[i].label]++;
+        voted = true;
+      }
+      if (!voted || y[r] >= numClasses)
+        continue;
+      size_t predicted =
+          (size_t)(max_element(votes.begin(), votes.end()) - votes.begin());
+      counts[y[r] * numClasses + predicted]++;
+    }
+  });
+  stats.oobConfusion.assign(numClasses * numClasses, 0);
+  for (const vector<uint64_t> &counts : partial)
+    for (size_t k = 0; k < counts.size(); ++k)
+      stats.oobConfusion[k] += counts[k];
+  size_t hits = 0;
+  stats.oobRows = 0;
+  for (size_t a = 0; a < numClasses; ++a)
+    for (size_t p = 0; p < numClasses; ++p) {
+      stats.oobRows += stats.oobConfusion[a * numClasses + p];
+      if (a == p)
+        hits += stats.oobConfusion[a * numClasses + p];
+    }
+  stats.oobAccuracy = stats.oobRows > 0 ? (double)hits / stats.oobRows : 0.0;
+}
+} // namespace
+
+BinnedDataset quantizeFeatures(const arma::fmat &data, size_t maxBins,
+                               size_t sampleRows, size_t numThreads) {
+  BinnedDataset b;
+  b.numRows = data.n_cols;
+  b.numFeatures = data.n_rows;
+  b.bins.resize(b.numRows * b.numFeatures);
+  b.upper.resize(b.numFeatures);
+  maxBins = min<size_t>(max<size_t>(maxBins, 2), 256);
+  const size_t step = max<size_t>(1, b.numRows / max<size_t>(sampleRows, 1));
+
+  parallelFor(b.numFeatures, numThreads, [&](size_t f) {
+    vector<float> sample;
+    for (size_t i = 0; i < b.numRows; i += step)
+      sample.push_back(data(f, i));
+    sort(sample.begin(), sample.end());
+    vector<float> distinct(sample);
+    distinct.erase(unique(distinct.begin(), distinct.end()), distinct.end());
+
+    vector<float> &up = b.upper[f];
+    if (distinct.size() <= maxBins) {
+      up = distinct;
+    } else {
+      const size_t m = sample.size();
+      for (size_t k = 1; k <= maxBins; ++k) {
+        float v = sample[min(m - 1, k * m / maxBins - 1)];
+        if (up.empty() || v > up.back())
+          up.push_back(v);
+      }
+    }
+    if (up.empty())
+      up.push_back(0.0f);
+
+    uint8_t *col = b.bins.data() + f * b.numRows;
+    for (size_t i = 0; i < b.numRows; ++i)
+      col[i] = binOf(up, data(f, i));
+  });
+  return b;
+}
+
+void trainHistogramForest(const arma::fmat &data,
+                          const arma::Row<size_t> &labels, size_t numClasses,
+                          const HistForestOptions &opts, ForestBuilder &out,
+                          HistTrainStats *stats) {
+  auto t0 = chrono::steady_clock::now();
+  size_t threads = opts.numThreads == 0 ? defaultThreadCount() : opts.numThreads;
+  BinnedDataset X = quantizeFeatures(data, opts.maxBins, 200000, threads);
+  auto t1 = chrono::steady_clock::now();
+
+  const size_t F = X.numFeatures;
+  size_t mtry = opts.dimFraction > 0.0
+                    ? (size_t)lround(opts.dimFraction * (double)F)
+                    : (size_t)lround(sqrt((double)F));
+  mtry = min(max<size_t>(mtry, 1), F);
+
+  // Trees in parallel; spare threads go to the histograms of large nodes.
+  size_t treeThreads = max<size_t>(1, min(opts.numTrees, threads));
+  size_t nodeThreads = max<size_t>(1, threads / treeThreads);
+  vector<GrownTree> trees(opts.numTrees);
+  parallelFor(opts.numTrees, treeThreads, [&](size_t t) {
+    TreeGrower g(X, labels.memptr(), numClasses, opts, mtry, nodeThreads,
+                 opts.seed + t);
+    g.grow();
+    trees[t].nodes = std::move(g.nodes);
+    trees[t].inBag = std::move(g.inBag);
+  });
+  auto t2 = chrono::steady_clock::now();
+
+  // Flatten in tree order; local child indices become global ones.
+  size_t numNodes = 0;
+  for (const GrownTree &tree : trees) {
+    out.beginTree();
+    int32_t base = -1;
+    for (const TreeNode &n : tree.nodes) {
+      ForestNode fn;
+      fn.feature = n.feature;
+      fn.threshold = n.threshold;
+      fn.left = n.left;
+      fn.right = n.right;
+      fn.classIdx = n.feature < 0 ? out.classIndex((float)n.label) : -1;
+      int32_t idx = out.addNode(fn);
+      if (base < 0)
+        base = idx;
+      if (n.feature >= 0) {
+        out.node(idx).left += base;
+        out.node(idx).right += base;
+      }
+    }
+    numNodes += tree.nodes.size();
+  }
+
+  if (stats != nullptr) {
+    stats->quantizeSeconds = chrono::duration<double>(t1 - t0).count();
+    stats->trainSeconds = chrono::duration<double>(t2 - t1).count();
+    stats->numNodes = numNodes;
+    if (opts.oobScore) {
+      auto t3 = chrono::steady_clock::now();
+      scoreOutOfBag(X, labels.memptr(), numClasses, trees, threads, *stats);
+      stats->oobSeconds =
+          chrono::duration<double>(chrono::steady_clock::now() - t3).count();
+    }
+  }
+}
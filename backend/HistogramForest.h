@@ -0,0 +1,70 @@
+#ifndef HISTOGRAM_FOREST_H
+#define HISTOGRAM_FOREST_H
+
+#include "ForestFormat.h"
+#include <armadillo>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- Features pre-quantized into at most 256 quantile bins ---
+// bins holds one uint8 column per feature (feature-major, numRows each).
+// A row falls in bin b of feature f iff upper[f][b-1] < x <= upper[f][b]
+// (the last bin also takes anything larger), so "bin <= b" is exactly
+// "x <= upper[f][b]" and splits translate to raw-float thresholds.
+struct BinnedDataset {
+  size_t numRows = 0;
+  size_t numFeatures = 0;
+  std::vector<uint8_t> bins;
+  std::vector<std::vector<float>> upper;
+
+  const uint8_t *column(size_t f) const { return bins.data() + f * numRows; }
+};
+
+// Bin edges come from the quantiles of up to `sampleRows` evenly spaced
+// rows; features with few distinct values get one bin per value.
+BinnedDataset quantizeFeatures(const arma::fmat &data, size_t maxBins = 256,
+                               size_t sampleRows = 200000,
+                               size_t numThreads = 0);
+
+struct HistForestOptions {
+  size_t numTrees = 20;
+  size_t minLeaf = 50;
+  size_t maxDepth = 0;      // 0 = unlimited
+  double dimFraction = 0.0; // features tried per split; 0 = sqrt(numFeatures)
+  size_t maxBins = 256;
+  size_t numThreads = 0; // 0 = every core
+  uint64_t seed = 1;     // tree t uses seed + t: results ignore numThreads
+  bool oobScore = true;  // score every row with the trees that did not see it
+};
+
+struct HistTrainStats {
+  double quantizeSeconds = 0.0;
+  double trainSeconds = 0.0;
+  size_t numNodes = 0;
+  // Out-of-bag estimate: accuracy over the oobRows rows left out of at least
+  // one bootstrap (about 1 - (1 - e^-1)^numTrees ~ 1 - 0.632^numTrees of
+  // them), voting only with those trees. Filled when opts.oobScore is set.
+  double oobAccuracy = 0.0;
+  size_t oobRows = 0;
+  double oobSeconds = 0.0;
+  // numClasses x numClasses, row-major: [actual * numClasses + predicted]
+  std::vector<uint64_t> oobConfusion;
+};
+
+// --- Histogram-based Random Forest trainer (Gini) ---
+// Each node accumulates a (bin x class) histogram per candidate feature and
+// scans it once for the best split, so the cost per node is O(rows +
+// bins) per feature however many distinct values a column has. Trees are
+// built concurrently; when there are fewer trees than threads, the spare
+// threads accumulate the histograms of large nodes in parallel (one
+// feature per task). Trees are written to `out` in order, ready for
+// ForestBuilder::serialize and the server's FlatForest. Bootstrap
+// membership is kept as one bitset per tree (numRows bits) for the
+// out-of-bag estimate, which replaces a held-out test set.
+void trainHistogramForest(const arma::fmat &data,
+                          const arma::Row<size_t> &labels, size_t numClasses,
+                          const HistForestOptions &opts, ForestBuilder &out,
+                          HistTrainStats *stats = nullptr);
+
+#endif // HISTOGRAM_FOREST_H
@@ -0,0 +1,43 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Number of worker threads to use when the caller passes 0.
+inline size_t defaultThreadCount() {
+  size_t n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : n;
+}
+
+// Runs fn(i) for every i in [0, n) on up to numThreads threads (0 = all
+// cores). Tasks are handed out dynamically; fn must be safe to call
+// concurrently for different i.
+template <typename Fn> void parallelFor(size_t n, size_t numThreads, Fn fn) {
+  if (numThreads == 0)
+    numThreads = defaultThreadCount();
+  numThreads = std::min(numThreads, n);
+  if (numThreads <= 1) {
+    for (size_t i = 0; i < n; ++i)
+      fn(i);
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1))
+      fn(i);
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+  for (size_t t = 1; t < numThreads; ++t)
+    threads.emplace_back(worker);
+  worker();
+  for (auto &th : threads)
+    th.join();
+}
+
+#endif // PARALLEL_H
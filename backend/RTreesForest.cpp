@@ -0,0 +1,65 @@
+#include "RTreesForest.h"
+#include <iostream>
+
+using namespace std;
+
+namespace {
+// Copies the subtree rooted at cvIdx and returns its index in the builder.
+int32_t copySubtree(const vector<cv::ml::DTrees::Node> &cvNodes,
+                    const vector<cv::ml::DTrees::Split> &cvSplits,
+                    int cvIdx, uint32_t numFeatures, ForestBuilder &builder,
+                    bool &ok) {
+  const cv::ml::DTrees::Node &src = cvNodes[cvIdx];
+  ForestNode dst{-1, 0.0f, -1, -1, -1};
+
+  if (src.split < 0) {
+    dst.classIdx = builder.classIndex((float)src.value);
+    return builder.addNode(dst);
+  }
+
+  // Only the primary split is used; surrogates exist for missing values.
+  const cv::ml::DTrees::Split &split = cvSplits[src.split];
+  if (split.subsetOfs >= 0 || split.varIdx < 0 ||
+      (uint32_t)split.varIdx >= numFeatures) {
+    ok = false;
+    return -1;
+  }
+
+  dst.feature = split.varIdx;
+  dst.threshold = split.c;
+  int32_t self = builder.addNode(dst);
+
+  // OpenCV sends (x <= c) left unless the split is inversed.
+  int leftSrc = split.inversed ? src.right : src.left;
+  int rightSrc = split.inversed ? src.left : src.right;
+  int32_t left =
+      copySubtree(cvNodes, cvSplits, leftSrc, numFeatures, builder, ok);
+  int32_t right =
+      copySubtree(cvNodes, cvSplits, rightSrc, numFeatures, builder, ok);
+  builder.node(self).left = left;
+  builder.node(self).right = right;
+  return self;
+}
+} // namespace
+
+bool forestFromRTrees(const cv::Ptr<cv::ml::RTrees> &model,
+                      uint32_t numFeatures, ForestBuilder &builder) {
+  if (model.empty() || !model->isTrained() || !model->isClassifier())
+    return false;
+
+  const vector<int> &cvRoots = model->getRoots();
+  const vector<cv::ml::DTrees::Node> &cvNodes = model->getNodes();
+  const vector<cv::ml::DTrees::Split> &cvSplits = model->getSplits();
+
+  bool ok = true;
+  for (int root : cvRoots) {
+    builder.beginTree();
+    copySubtree(cvNodes, cvSplits, root, numFeatures, builder, ok);
+    if (!ok) {
+      cerr << "RTrees model uses categorical splits; keeping XML model."
+           << endl;
+      return false;
+    }
+  }
+  return builder.numTrees() > 0;
+}
@@ -0,0 +1,99 @@
+#ifndef TENSOR_INTEROP_H
+#define TENSOR_INTEROP_H
+
+#include <memory>
+#include <stdexcept>
+#include <torch/torch.h>
+
+// --- Zero-copy handoff between libtorch, OpenCV and Armadillo ---
+// Views share memory with their source; nothing is copied unless a tensor
+// is not already contiguous on the CPU. Ownership follows the consumer:
+//  - tensor -> cv::Mat / arma::fmat returns a TensorView, which holds a
+//    reference to the tensor for as long as the view object lives;
+//  - cv::Mat / arma::fmat -> tensor uses from_blob with a deleter that
+//    holds the source (cv::Mat refcount, shared_ptr for arma), so the
+//    tensor keeps the memory alive on its own.
+// The OpenCV and Armadillo halves are compiled only when their headers are
+// available.
+
+template <typename View> struct TensorView {
+  torch::Tensor owner; // keeps view's memory alive
+  View view;
+};
+
+// The tensor itself when it is already contiguous on the CPU, otherwise a
+// contiguous CPU copy (the only case in which anything is copied).
+inline torch::Tensor cpuContiguous(const torch::Tensor &t) {
+  if (t.device().is_cpu() && t.is_contiguous())
+    return t;
+  return t.to(torch::kCPU).contiguous();
+}
+
+#if __has_include(<opencv2/core.hpp>)
+#include <opencv2/core.hpp>
+
+inline int cvTypeFor(torch::ScalarType type) {
+  switch (type) {
+  case torch::kFloat:
+    return CV_32F;
+  case torch::kDouble:
+    return CV_64F;
+  case torch::kInt:
+    return CV_32S;
+  case torch::kByte:
+    return CV_8U;
+  default:
+    throw std::invalid_argument("tensorAsMat: unsupported tensor dtype");
+  }
+}
+
+// [rows, cols] (or [rows] as a column) -> cv::Mat header over the same
+// memory, one sample per row (cv::ml::ROW_SAMPLE).
+inline TensorView<cv::Mat> tensorAsMat(const torch::Tensor &t) {
+  if (t.dim() != 1 && t.dim() != 2)
+    throw std::invalid_argument("tensorAsMat: expected a 1-D or 2-D tensor");
+  torch::Tensor owner = cpuContiguous(t);
+  int rows = (int)owner.size(0);
+  int cols = owner.dim() == 2 ? (int)owner.size(1) : 1;
+  return {owner, cv::Mat(rows, cols, cvTypeFor(owner.scalar_type()),
+                         owner.data_ptr())};
+}
+
+// Continuous single-channel float cv::Mat -> [rows, cols] tensor. The
+// deleter holds a cv::Mat copy, so the pixels outlive the caller's Mat.
+inline torch::Tensor matAsTensor(const cv::Mat &m) {
+  if (!m.isContinuous() || m.type() != CV_32F)
+    throw std::invalid_argument("matAsTensor: expected a continuous CV_32F Mat");
+  auto *keep = new cv::Mat(m);
+  return torch::from_blob(
+      keep->data, {keep->rows, keep->cols},
+      [keep](void *) { delete keep; }, torch::kFloat);
+}
+#endif
+
+#if __has_include(<armadillo>)
+#include <armadillo>
+
+// [samples, features] -> arma::fmat (features x samples): the same bytes
+// read column-major, i.e. one sample per column as mlpack expects.
+inline TensorView<arma::fmat> tensorAsFmat(const torch::Tensor &t) {
+  if (t.dim() != 2 || t.scalar_type() != torch::kFloat)
+    throw std::invalid_argument("tensorAsFmat: expected a 2-D float tensor");
+  // Built in place: copying an aux-memory fmat would copy the data.
+  torch::Tensor owner = cpuContiguous(t);
+  return {owner, arma::fmat(owner.data_ptr<float>(), owner.size(1),
+                            owner.size(0), false, true)};
+}
+
+// arma::fmat (features x samples) -> [samples, features] tensor. The
+// deleter holds the shared_ptr, so the matrix lives as long as the tensor.
+inline torch::Tensor fmatAsTensor(std::shared_ptr<arma::fmat> m) {
+  float *data = m->memptr();
+  int64_t samples = m->n_cols, features = m->n_rows;
+  return torch::from_blob(
+      data, {samples, features}, [m](void *) mutable { m.reset(); },
+      torch::kFloat);
+}
+#endif
+
+#endif // TENSOR_INTEROP_H
@@ -1,12 +1,19 @@
+#include "CantonHistory.h"
+#include "ContextualLSTM.h"
+#include "DatasetLoader.h"
+#include "DatasetStore.h"
 #include "Encoders.h"
+#include "Evaluation.h"
+#include "ForestFormat.h"
+#include "ForestSweep.h"
 #include "Helpers.h"
+#include "HistogramForest.h"
+#include "Parallel.h"
 #include <armadillo>
 #include <chrono>
 #include <fstream>
 #include <iostream>
-#include <map>
 #include <mlpack.hpp>
-#include <sstream>
 #include <vector>
 
 // --- GPU / LIBTORCH INCLUDES ---
@@ -20,55 +27,214 @@ using namespace std;
 using namespace arma;
 
 // ==========================================
-// 1. LIBTORCH GPU LSTM MODULE (RESTORED)
+// 1. RANDOM FOREST HELPERS
 // ==========================================
-// Note: This struct is available for use if you switch to a custom LibTorch loop.
-// The current main() uses MLPack's RNN, which runs on GPU via NVBLAS.
-struct ContextualLSTMImpl : torch::nn::Module
+using Forest = RandomForest<GiniGain, RandomDimensionSelect>;
+
+// Province and subtype as categorical dimensions: one mapping per category
+// plus the "missing" category 0 (see FEAT_* in DatasetLoader.h).
+data::DatasetInfo categoricalInfo(const DatasetEncoders& enc, size_t numDims)
 {
-    torch::nn::Embedding cantonEmb{nullptr};
-    torch::nn::Embedding serviceEmb{nullptr};
-    torch::nn::LSTM lstm{nullptr};
-    torch::nn::Linear fc{nullptr};
-    int64_t hiddenSize;
-
-    ContextualLSTMImpl(int64_t numCantones, int64_t numServicios,
-                       int64_t embCantonDim = 16, int64_t embServiceDim = 32,
-                       int64_t hidden = 64)
-        : hiddenSize(hidden)
+    data::DatasetInfo info(numDims);
+    const size_t numCategories[] = {enc.prov.numClasses() + 1, enc.subtipo.numClasses() + 1};
+    for (size_t c = 0; c < 2; ++c)
     {
-        cantonEmb = register_module(
-            "cantonEmb", torch::nn::Embedding(numCantones, embCantonDim));
-        serviceEmb = register_module(
-            "serviceEmb", torch::nn::Embedding(numServicios, embServiceDim));
+        size_t dim = CATEGORICAL_FEATURES[c];
+        info.Type(dim) = data::Datatype::categorical;
+        for (size_t k = 0; k < numCategories[c]; ++k)
+            info.MapString<size_t>(to_string(k), dim);
+    }
+    return info;
+}
 
-        lstm = register_module(
-            "lstm", torch::nn::LSTM(
-                torch::nn::LSTMOptions(embCantonDim + embServiceDim, hidden)
-                .batch_first(true)));
+double accuracy(const Forest& rf, const fmat& data, const Row<size_t>& labels)
+{
+    Row<size_t> predictions;
+    rf.Classify(data, predictions);
+    return (double)accu(predictions == labels) / labels.n_elem;
+}
+
+// --compare-onehot: retrains on the old 24-row one-hot layout and reports
+// memory, training time and accuracy next to the categorical forest.
+void compareOneHotLayout(const fmat& trainData, const Row<size_t>& trainLabels,
+                         const fmat& testData, const Row<size_t>& testLabels,
+                         size_t numClasses, const Forest& catRf, double catSeconds)
+{
+    cout << "\n--- Categorical vs One-Hot Province ---" << endl;
+    fmat trainOneHot, testOneHot;
+    expandOneHotProvince(trainData, trainOneHot);
+    expandOneHotProvince(testData, testOneHot);
+
+    Forest rfOneHot;
+    auto t0 = chrono::steady_clock::now();
+    rfOneHot.Train(trainOneHot, trainLabels, numClasses, 20, 50);
+    double oneHotSeconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    double catMB = trainData.n_elem * sizeof(float) / (1024.0 * 1024.0);
+    double oneHotMB = trainOneHot.n_elem * sizeof(float) / (1024.0 * 1024.0);
+    cout << "  Layout       Dims  Train MB  Train s  Accuracy" << endl;
+    cout << "  one-hot      " << trainOneHot.n_rows << "  " << oneHotMB << "  " << oneHotSeconds
+         << "  " << accuracy(rfOneHot, testOneHot, testLabels) << endl;
+    cout << "  categorical  " << trainData.n_rows << "  " << catMB << "  " << catSeconds << "  "
+         << accuracy(catRf, testData, testLabels) << endl;
+    cout << "  Saved: " << (oneHotMB - catMB) << " MB (" << (1.0 - catMB / oneHotMB) * 100.0
+         << "%), training " << oneHotSeconds / catSeconds << "x faster" << endl;
+}
 
-        fc = register_module("fc", torch::nn::Linear(hidden, numServicios));
+// Histogram-binned forest with the production settings, wrapped in the
+// server's format. False (after a message) if the image is invalid.
+bool trainFlatHistogramForest(const fmat& trainData, const Row<size_t>& trainLabels,
+                              size_t numClasses, size_t threadBudget, FlatForest& forest,
+                              HistTrainStats& stats)
+{
+    HistForestOptions opts;
+    opts.numTrees = 20;
+    opts.minLeaf = 50;
+    opts.numThreads = threadBudget;
+    ForestBuilder builder;
+    trainHistogramForest(trainData, trainLabels, numClasses, opts, builder, &stats);
+
+    vector<string> names = featureNames(trainData.n_rows);
+    if (!forest.adopt(builder.serialize((uint32_t)trainData.n_rows, forestSchemaHash(names))))
+    {
+        cerr << "Histogram forest: invalid image" << endl;
+        return false;
     }
+    return true;
+}
 
-    torch::Tensor forward(torch::Tensor cantonIds, torch::Tensor serviceSeq)
+// --hist-forest: trains the histogram-binned forest, compares it with
+// mlpack's on the holdout and exports it in the server's format.
+void compareHistogramForest(const fmat& trainData, const Row<size_t>& trainLabels,
+                            const fmat& testData, const Row<size_t>& testLabels,
+                            size_t numClasses, const Forest& rf, double rfSeconds,
+                            size_t threadBudget)
+{
+    cout << "\n--- Histogram Forest ---" << endl;
+    FlatForest forest;
+    HistTrainStats stats;
+    if (!trainFlatHistogramForest(trainData, trainLabels, numClasses, threadBudget, forest, stats))
+        return;
+    double histSeconds = stats.quantizeSeconds + stats.trainSeconds;
+    cout << "  histogram: " << histSeconds << " s (binning " << stats.quantizeSeconds << " s), "
+         << stats.numNodes << " nodes, " << rfSeconds / histSeconds << "x faster than mlpack" << endl;
+    cout << "  rf_hist.bin out-of-bag accuracy: " << stats.oobAccuracy << " over " << stats.oobRows
+         << " rows (" << stats.oobSeconds << " s)" << endl;
+    if (testData.n_cols > 0)
     {
-        auto cEmb = cantonEmb(cantonIds);
-        auto sEmb = serviceEmb(serviceSeq);
-        auto cEmbRep = cEmb.unsqueeze(1).repeat({1, sEmb.size(1), 1});
-        auto x = torch::cat({cEmbRep, sEmb}, 2);
-        auto lstmOut = std::get<0>(lstm(x));
-        auto last = lstmOut.select(1, lstmOut.size(1) - 1);
-        return fc(last);
+        vector<uint8_t> hit(testData.n_cols);
+        parallelFor(testData.n_cols, threadBudget, [&](size_t i) {
+            hit[i] = forest.predict(testData.colptr(i)) == (float)testLabels(i);
+        });
+        cout << "  holdout accuracy: histogram "
+             << (double)count(hit.begin(), hit.end(), 1) / hit.size() << ", mlpack "
+             << accuracy(rf, testData, testLabels) << endl;
     }
-};
+    if (forest.save("rf_hist.bin"))
+        cout << "  Saved rf_hist.bin" << endl;
+}
+
+// --holdout 0: every row trains the histogram forest, which is the model
+// saved (rf_hist.bin); its out-of-bag votes are the evaluation report.
+bool trainOutOfBagModel(const fmat& trainData, const Row<size_t>& trainLabels,
+                        const vector<string>& classNames, size_t threadBudget)
+{
+    const size_t numClasses = classNames.size();
+    FlatForest forest;
+    HistTrainStats stats;
+    cout << "Training histogram RF on all " << trainData.n_cols << " rows (MinLeaf=50)..." << endl;
+    if (!trainFlatHistogramForest(trainData, trainLabels, numClasses, threadBudget, forest, stats))
+        return false;
+    cout << "RF trained in " << stats.quantizeSeconds + stats.trainSeconds << " s (" << stats.numNodes
+         << " nodes)." << endl;
+    if (!forest.save("rf_hist.bin"))
+        return false;
+    cout << "RF Saved to rf_hist.bin." << endl;
+
+    cout << "\n--- RF Evaluation ---" << endl;
+    EvalReport report;
+    report.source = "out-of-bag";
+    report.numClasses = numClasses;
+    report.rows = stats.oobRows;
+    report.confusion = stats.oobConfusion;
+    report.seconds = stats.oobSeconds;
+    report.rowsPerSec = stats.oobSeconds > 0 ? stats.oobRows / stats.oobSeconds : 0.0;
+    report.threads = threadBudget == 0 ? defaultThreadCount() : threadBudget;
+    finalizeReport(report);
+    printEvalReport(report, classNames);
+    string reportPath = evalReportPathFor("rf_hist.bin");
+    if (writeEvalReportJson(reportPath, "rf_hist.bin", report, classNames))
+        cout << "Report written to " << reportPath << endl;
+    return true;
+}
 
-TORCH_MODULE(ContextualLSTM);
+// Parses `path` and appends its rows to the open store. The encoders already
+// hold every known name, so the parse only adds ids for new ones; existing
+// rows keep their ids.
+bool appendToStore(DatasetStore& store, DatasetEncoders& enc, const string& path)
+{
+    uint64_t appendStamp = sourceStamp(path);
+    if (store.hasSource(appendStamp))
+    {
+        cout << path << " is already in the dataset store, skipping." << endl;
+        return true;
+    }
+    DatasetColumns cols;
+    LoadStats loadStats;
+    if (!loadDatasetCsv(path, enc, cols, loadStats)) return false;
+    fmat newData;
+    Row<size_t> newLabels;
+    materializeFeatures(cols, newData, newLabels);
+    cols = DatasetColumns();
+    if (!store.append(enc, newData, newLabels, appendStamp, path)) return false;
+    cout << "Appended " << newData.n_cols << " rows from " << path << " in " << loadStats.seconds
+         << " s (store now " << store.numRows() << " rows)" << endl;
+    return true;
+}
 
 // ==========================================
 // 2. MAIN APPLICATION
 // ==========================================
-int main()
+int main(int argc, char** argv)
 {
+    bool compareOneHot = false;
+    string appendPath; // new monthly file to add to the dataset store
+    bool sweep = false;
+    size_t sweepSamples = 0; // 0 = full grid
+    size_t threadBudget = 0; // 0 = every core
+    bool histForest = false;
+    double holdout = 0.3; // share of rows held out for testing; 0 = train on all
+    bool torchLstm = false; // ContextualLSTM through a torch data loader instead of mlpack's RNN
+    for (int a = 1; a < argc; ++a)
+    {
+        string arg = argv[a];
+        if (arg == "--compare-onehot") compareOneHot = true;
+        else if (arg == "--append" && a + 1 < argc) appendPath = argv[++a];
+        else if (arg == "--sweep") sweep = true;
+        else if (arg == "--sweep-random" && a + 1 < argc)
+        {
+            sweep = true;
+            sweepSamples = (size_t)max(1, atoi(argv[++a]));
+        }
+        else if (arg == "--hist-forest") histForest = true;
+        else if (arg == "--torch-lstm") torchLstm = true;
+        else if (arg == "--holdout" && a + 1 < argc) holdout = min(0.9, max(0.0, atof(argv[++a])));
+        else if (arg == "--threads" && a + 1 < argc) threadBudget = (size_t)max(0, atoi(argv[++a]));
+        else
+        {
+            cerr << "Usage: " << argv[0]
+                 << " [--compare-onehot] [--append new.csv] [--sweep | --sweep-random N] [--hist-forest]"
+                 << " [--holdout RATIO] [--torch-lstm] [--threads N]"
+                 << endl;
+            return 1;
+        }
+    }
+    if (holdout == 0.0 && (sweep || compareOneHot || histForest))
+    {
+        cerr << "--sweep, --compare-onehot and --hist-forest score a holdout; use --holdout > 0" << endl;
+        return 1;
+    }
+
     // --- A. GPU & LIBTORCH CHECKS (RESTORED) ---
     cout << "--- System Check ---" << endl;
 
@@ -100,110 +266,156 @@ int main()
     cout << "\n--- 1. Data Loading ---" << endl;
     string filename = "../Datasets/join_2022_05_v2.csv";
 
-    LabelEncoder encProv, encSubtipo, encServ;
-    HierarchicalCantonEncoder encCanton;
+    DatasetEncoders enc;
+    LabelEncoder& encServ = enc.serv;
 
-    // --- PASS 1: SCAN METADATA ---
-    cout << "Pass 1: Scanning file for metadata..." << endl;
-    ifstream file(filename);
-    if (!file.is_open())
+    // --- DATASET STORE: skip ingestion while the CSV is unchanged ---
+    string storeDir = storePathFor(filename);
+    uint64_t stamp = sourceStamp(filename);
+    DatasetStore store;
+    fmat dataMat;
+    Row<size_t> labelMat;
+    if (store.open(storeDir, stamp, &enc))
     {
-        cerr << "Error: " << filename << endl;
-        return -1;
+        cout << "Dataset store hit: " << storeDir << " (" << store.numRows() << " rows, "
+             << store.numAppended() << " appended files)" << endl;
     }
-
-    string line, cell, header;
-    getline(file, header);
-
-    // Count columns dynamically
-    stringstream ss(header);
-    int totalCsvCols = 0;
-    while (getline(ss, cell, ',')) totalCsvCols++;
-    int numStatsCols = max(0, totalCsvCols - 5);
-
-    int n_feats = 1 + 24 + 1 + 1 + numStatsCols; // Date + Prov(24) + Canton + Subtype + Stats
-    size_t totalRows = 0;
-
-    while (getline(file, line))
+    else
     {
-        stringstream lineStream(line);
-        vector<string> row;
-        row.reserve(totalCsvCols);
-        while (getline(lineStream, cell, ',')) row.push_back(cell);
-        if (row.size() < 5) continue;
-
-        encProv.encode(row[0]);
-        encCanton.encode((int)encProv.encode(row[0]), row[1]);
-        encServ.encode(row[2]);
-        encSubtipo.encode(row[3]);
-        totalRows++;
+        // A changed CSV rebuilds the store; files appended to the old one
+        // are appended again below so their months are not lost.
+        vector<string> previouslyAppended = appendedSourcesOf(storeDir);
+
+        // --- SINGLE PASS: MMAP + PARALLEL CHUNKED TOKENIZING ---
+        cout << "Single pass: mapping and parsing " << filename << "..." << endl;
+        DatasetColumns cols;
+        LoadStats loadStats;
+        if (!loadDatasetCsv(filename, enc, cols, loadStats)) return -1;
+        cout << "Parsed " << loadStats.rows << " rows (" << loadStats.bytes / (1024 * 1024) << " MB) in "
+             << loadStats.seconds << " s (" << loadStats.chunks << " chunks) -> " << loadStats.mbPerSec()
+             << " MB/s" << endl;
+
+        // Materialize the feature matrix once, then drop the column buffers
+        materializeFeatures(cols, dataMat, labelMat);
+        cols = DatasetColumns();
+
+        // Once persisted, train from the mapping like a store hit would
+        if (saveDatasetStore(storeDir, stamp, enc, dataMat, labelMat) && store.open(storeDir, stamp))
+        {
+            cout << "Dataset store written: " << storeDir << endl;
+            dataMat.reset();
+            labelMat.reset();
+        }
+        for (const string& path : previouslyAppended)
+        {
+            if (!store.isOpen() || !appendToStore(store, enc, path))
+                cerr << "Warning: rows previously appended from " << path
+                     << " are not in the rebuilt dataset" << endl;
+        }
     }
-    encProv.freeze();
-    encSubtipo.freeze();
-
-    // --- PASS 2: LOAD DATA ---
-    cout << "Pass 2: Loading " << totalRows << " rows directly to RAM..." << endl;
-    fmat dataMat(n_feats, totalRows);
-    Row<size_t> labelMat(totalRows);
-    map<int, vector<float>> canton_histories;
-
-    file.clear();
-    file.seekg(0);
-    getline(file, header);
-    size_t idx = 0;
-    while (getline(file, line) && idx < totalRows)
+
+    // --- INCREMENTAL APPEND: parse only the new file ---
+    if (!appendPath.empty())
     {
-        stringstream lineStream(line);
-        vector<string> row;
-        row.reserve(totalCsvCols);
-        while (getline(lineStream, cell, ',')) row.push_back(cell);
-        if (row.size() < 5) continue;
-
-        float targetVal = (float)encServ.encode(row[2]);
-        if (targetVal < 0) continue;
-        labelMat(idx) = (size_t)targetVal;
-
-        // Features
-        dataMat(0, idx) = parseNumeric(row[4]); // Date
-        int provId = (int)encProv.encode(row[0]);
-        for (int p = 0; p < 24; ++p) dataMat(1 + p, idx) = (p == provId) ? 1.0f : 0.0f; // OneHot Prov
-
-        int cantonId = (int)encCanton.encode(provId, row[1]);
-        dataMat(25, idx) = (float)cantonId;
-        dataMat(26, idx) = (float)encSubtipo.encode(row[3]);
-
-        for (int k = 0; k < numStatsCols; ++k)
+        if (!store.isOpen())
         {
-            if (5 + k < row.size()) dataMat(27 + k, idx) = parseNumeric(row[5 + k]);
+            cerr << "--append needs a dataset store for " << filename << endl;
+            return -1;
         }
+        if (!appendToStore(store, enc, appendPath)) return -1;
+    }
 
-        // History
-        canton_histories[cantonId].push_back(targetVal);
-        idx++;
+    if (store.isOpen())
+    {
+        // Advanced constructors: the matrices alias the mapped pages, no copy
+        dataMat = fmat(store.featureData(), store.numFeatures(), store.numRows(), false, false);
+        labelMat = Row<size_t>(store.labelData(), store.numRows(), false, false);
+        cout << "Mapped " << store.bytes() / (1024 * 1024) << " MB from the dataset store." << endl;
     }
-    file.close();
+
+    // History (canton id per sample is a feature row, so both paths share it)
+    CantonHistories canton_histories = buildCantonHistories(dataMat, FEAT_CANTON, labelMat);
 
     // --- C. RANDOM FOREST ---
     cout << "\n--- 2. Random Forest ---" << endl;
-    fmat trainData, testData;
-    Row<size_t> trainLabels, testLabels;
-    data::Split(dataMat, labelMat, trainData, testData, trainLabels, testLabels, 0.3);
-    dataMat.clear(); // Free RAM
-
-    RandomForest<GiniGain, RandomDimensionSelect> rf;
-    cout << "Training RF (MinLeaf=50)..." << endl;
-    rf.Train(trainData, trainLabels, encServ.numClasses(), 20, 50);
+    // Shuffle columns in place, then alias both halves (no copy of the data).
+    // With --holdout 0 everything trains and accuracy comes from out-of-bag rows.
+    size_t nTrain = holdout > 0.0 ? shuffleSplitInPlace(dataMat, labelMat, holdout) : dataMat.n_cols;
+    size_t nTest = dataMat.n_cols - nTrain;
+    fmat trainData(dataMat.memptr(), dataMat.n_rows, nTrain, false, true);
+    fmat testData(dataMat.colptr(nTrain), dataMat.n_rows, nTest, false, true);
+    Row<size_t> trainLabels(labelMat.memptr(), nTrain, false, true);
+    Row<size_t> testLabels(labelMat.memptr() + nTrain, nTest, false, true);
+
+    data::DatasetInfo info = categoricalInfo(enc, trainData.n_rows);
+
+    // --sweep: try many forests on the split already in memory, then stop
+    if (sweep)
+    {
+        vector<SweepConfig> configs = sweepSamples > 0 ? sweepRandom(sweepSamples) : sweepGrid();
+        vector<SweepResult> results = runSweep(configs, trainData, info, trainLabels, testData, testLabels,
+                                               encServ.numClasses(), threadBudget);
+        printSweepTable(results);
+        return 0;
+    }
 
-    mlpack::data::Save("rf_model.bin", "rf_model", rf, false);
-    cout << "RF Saved." << endl;
+    // Without a holdout the histogram forest is the model: its out-of-bag
+    // votes give the accuracy, so no second forest is trained.
+    Forest rf;
+    if (holdout == 0.0)
+    {
+        if (!trainOutOfBagModel(trainData, trainLabels, encServ.classes(), threadBudget)) return -1;
+    }
+    else
+    {
+        cout << "Training RF (MinLeaf=50, categorical province/subtype)..." << endl;
+        auto rfStart = chrono::steady_clock::now();
+        rf.Train(trainData, info, trainLabels, encServ.numClasses(), 20, 50);
+        double rfSeconds = chrono::duration<double>(chrono::steady_clock::now() - rfStart).count();
+        cout << "RF trained in " << rfSeconds << " s." << endl;
+
+        if (compareOneHot)
+            compareOneHotLayout(trainData, trainLabels, testData, testLabels, encServ.numClasses(), rf,
+                                rfSeconds);
+        if (histForest)
+            compareHistogramForest(trainData, trainLabels, testData, testLabels, encServ.numClasses(), rf,
+                                   rfSeconds, threadBudget);
+
+        mlpack::data::Save("rf_model.bin", "rf_model", rf, false);
+        cout << "RF Saved." << endl;
+
+        // --- EVALUATION: score the whole test set, report next to the model ---
+        if (testData.n_cols > 0)
+        {
+            cout << "\n--- RF Evaluation ---" << endl;
+            EvalReport report =
+                evaluateClassifier(rf, testData, testLabels, encServ.numClasses(), threadBudget);
+            printEvalReport(report, encServ.classes());
+            string reportPath = evalReportPathFor("rf_model.bin");
+            if (writeEvalReportJson(reportPath, "rf_model.bin", report, encServ.classes()))
+                cout << "Report written to " << reportPath << endl;
+        }
+    }
 
     // --- D. LSTM ---
     cout << "\n--- 3. Contextual LSTM (Probabilistic) ---" << endl;
 
     size_t totalLstmSamples = 0;
-    for (auto const& [cantonId, history] : canton_histories)
+    for (size_t c = 0; c < canton_histories.numCantons(); ++c)
+    {
+        if (canton_histories.length(c) > 1) totalLstmSamples += (canton_histories.length(c) - 1);
+    }
+
+    // --torch-lstm: windows straight from the CSR histories, shuffled minibatches
+    if (torchLstm)
     {
-        if (history.size() > 1) totalLstmSamples += (history.size() - 1);
+        ContextualLSTM model((int64_t)canton_histories.numCantons(), (int64_t)encServ.numClasses());
+        TorchTrainOptions opts;
+        opts.torchThreads = threadBudget;
+        trainContextualLSTM(model, canton_histories, (int64_t)encServ.numClasses(), opts);
+        torch::save(model, "contextual_lstm.pt");
+        cout << "Models Saved." << endl;
+        return 0;
     }
 
     // 1. Setup Dimensions
@@ -221,11 +433,14 @@ int main()
     size_t c_idx = 0;
     float maxLabelFound = -1.0f;
 
-    for (auto const& [cantonId, history] : canton_histories)
+    for (size_t c = 0; c < canton_histories.numCantons(); ++c)
     {
-        if (history.size() < 2) continue;
+        const float* history = canton_histories.history(c);
+        size_t length = canton_histories.length(c);
+        float cantonId = (float)canton_histories.cantonCode[c];
+        if (length < 2) continue;
 
-        for (size_t i = 0; i < history.size() - 1; ++i)
+        for (size_t i = 0; i < length - 1; ++i)
         {
             inputCube(0, c_idx, 0) = history[i] / (float)numClasses;
             inputCube(1, c_idx, 0) = (float)cantonId / maxCant;
@@ -240,7 +455,7 @@ int main()
             c_idx++;
         }
     }
-    canton_histories.clear(); // Free RAM
+    canton_histories = CantonHistories(); // Free RAM
 
     cout << "  Max Label in Data: " << maxLabelFound << endl;
 
@@ -262,7 +477,14 @@ int main()
     ens::Adam optimizer(0.001, BATCH_SIZE, 0.9, 0.999, 1e-8, iterPerEpoch * EPOCHS, 1e-9);
 
     cout << "Training LSTM Classifier..." << endl;
+    auto lstmStart = chrono::steady_clock::now();
     rnn.Train(inputCube, targetCube, optimizer, ens::PrintLoss(), ens::ProgressBar());
+    double lstmSeconds = chrono::duration<double>(chrono::steady_clock::now() - lstmStart).count();
+    // ensmallen's maxIterations counts data points, not batches, so the
+    // optimizer stops after iterPerEpoch * EPOCHS points.
+    size_t lstmPoints = min(iterPerEpoch * EPOCHS, totalLstmSamples * EPOCHS);
+    cout << "LSTM trained in " << lstmSeconds << " s (" << lstmPoints << " samples, "
+         << (size_t)(lstmPoints / lstmSeconds) << " samples/s)" << endl;
 
     // --- 4. PREDICTION DEMO (DO THIS BEFORE SAVING) ---
     // Moving this up prevents memory corruption from the Save() function
@@ -308,7 +530,7 @@ int main()
 
     // --- 5. SAVE MODELS (DO THIS LAST) ---
     cout << "\n--- Saving Models ---" << endl;
-    mlpack::data::Save("rf_model.bin", "rf_model", rf, false);
+    if (holdout > 0.0) mlpack::data::Save("rf_model.bin", "rf_model", rf, false);
     mlpack::data::Save("lstm_model.bin", "lstm_model", rnn, false);
     cout << "Models Saved." << endl;
 